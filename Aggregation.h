@@ -0,0 +1,262 @@
+#ifndef AGGREGATION_H
+#define AGGREGATION_H
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <boost/functional/hash.hpp>
+#include "Relation.h"
+
+using namespace std;
+
+//Hash aggregation for group ( attribute-list ) aggregate ( aggregate-list ) expr. A GroupTable
+//finds the group of every row of a range of a relation through a chained hash table over the
+//group attributes, and keeps each group's running aggregates. INTEGER attributes are read,
+//hashed, compared and summed as numbers, VARCHAR ones as their cells (see GroupSpec).
+//Every thread of the pool aggregates its own range of rows into a table of its own, then the
+//tables are merged into the first one (see HashAggregateOp). Tables of later ranges are merged
+//in later, so the groups stay in order of their first row.
+
+enum AggregateFunction { CountAgg=0, SumAgg, MinAgg, MaxAgg, AvgAgg };
+
+const char* aggregateSpellings[] = { "count", "sum", "min", "max", "avg" };
+
+const int GROUP_TABLE_BUCKETS = 1024; //buckets a GroupTable starts with, doubled as it fills up
+
+class AggregateCall{
+//one entry of an aggregate-list: function ( attribute-name ), or count ( * ) with attr ""
+public:
+	AggregateFunction function;
+	string attr;
+
+	AggregateCall(AggregateFunction Function, string Attr) {
+		function = Function;
+		attr = Attr;
+	}
+
+	string name() {
+		//its column of the result: count for count ( * ), function_attr otherwise (e.g. sum_homeruns)
+		if(attr == "") {
+			return aggregateSpellings[function];
+		}
+		return string(aggregateSpellings[function]) + "_" + attr;
+	}
+};
+
+AggregateCall countOf(string attr = "") { return AggregateCall(CountAgg, attr); }
+AggregateCall sumOf(string attr) { return AggregateCall(SumAgg, attr); }
+AggregateCall minOf(string attr) { return AggregateCall(MinAgg, attr); }
+AggregateCall maxOf(string attr) { return AggregateCall(MaxAgg, attr); }
+AggregateCall avgOf(string attr) { return AggregateCall(AvgAgg, attr); }
+
+string longToString(long number) {
+	stringstream ss;
+	ss << number;
+	return ss.str();
+}
+
+class GroupSpec{
+//what a GroupTable aggregates: the input's attributes it reads, column i being INTEGER
+//intColumns[slots[i]] if intCols[i], VARCHAR rel->columns[slots[i]] otherwise
+public:
+	vector<bool> intCols;
+	vector<int> slots;
+	vector< vector<int> > intColumns;
+	Relation* rel;
+	vector<int> keyCols;	//group attributes
+	vector<AggregateFunction> functions;
+	vector<int> aggCols;	//the attribute of every aggregate, -1 for count ( * )
+
+	int height() {
+		return (intColumns.empty() ? rel->getHeight() : intColumns[0].size());
+	}
+
+	int getInt(int col, int row) {
+		return intColumns[slots[col]][row];
+	}
+
+	boost::string_ref getView(int col, int row) {
+		return rel->columns[slots[col]].getView(row);
+	}
+
+	string cell(int col, int row) {
+		return (intCols[col] ? intToString(getInt(col, row)) : getView(col, row).to_string());
+	}
+};
+
+class GroupTable{
+public:
+	vector<int> firstRows;	//every group's first row, in order
+	vector<long> rowCounts;	//every group's rows
+	vector<long> values;	//aggregate a of group g at g * aggregates + a: the sum (sum, avg),
+							//the value (min, max of INTEGER) or the row holding it (of VARCHAR)
+
+	GroupTable(GroupSpec* Spec) {
+		spec = Spec;
+		aggregates = spec->functions.size();
+		head.assign(GROUP_TABLE_BUCKETS, -1);
+	}
+
+	int size() {
+		return firstRows.size();
+	}
+
+	long bytes() {
+		return (long)head.size() * sizeof(int) + (long)size() * (2 * sizeof(int) + sizeof(unsigned long long) + (aggregates + 1) * sizeof(long));
+	}
+
+	void addRows(int start, int end) {
+		for(int row = start; row < end; row++) {
+			unsigned long long hash = hashRow(row);
+			int g = findGroup(hash, row);
+			if(g < 0) {
+				g = newGroup(hash, row);
+				for(int a = 0; a < aggregates; a++) {
+					values.push_back(initialValue(a, row));
+				}
+				rowCounts.push_back(1);
+				continue;
+			}
+			rowCounts[g]++;
+			for(int a = 0; a < aggregates; a++) {
+				long& value = values[(long)g * aggregates + a];
+				value = combine(a, value, initialValue(a, row));
+			}
+		}
+	}
+
+	void merge(GroupTable& other) {
+		//other's groups into this table, other having aggregated later rows of the same relation
+		for(int og = 0; og < other.size(); og++) {
+			int row = other.firstRows[og];
+			int g = findGroup(other.hashes[og], row);
+			if(g < 0) {
+				newGroup(other.hashes[og], row);
+				values.insert(values.end(), other.values.begin() + (long)og * aggregates, other.values.begin() + (long)(og + 1) * aggregates);
+				rowCounts.push_back(other.rowCounts[og]);
+				continue;
+			}
+			rowCounts[g] += other.rowCounts[og];
+			for(int a = 0; a < aggregates; a++) {
+				long& value = values[(long)g * aggregates + a];
+				value = combine(a, value, other.values[(long)og * aggregates + a]);
+			}
+		}
+	}
+
+	string result(int g, int a) {
+		//aggregate a of group g, as its cell
+		long value = values[(long)g * aggregates + a];
+		if(spec->functions[a] == CountAgg) {
+			return longToString(rowCounts[g]);
+		}
+		if(spec->functions[a] == AvgAgg) {
+			return longToString(value / rowCounts[g]); //truncated, as integer division
+		}
+		return (isInt(a) ? longToString(value) : spec->getView(spec->aggCols[a], value).to_string());
+	}
+
+private:
+	GroupSpec* spec;
+	int aggregates;
+	vector<int> head;	//every bucket's first group
+	vector<int> next;	//every group's next group in its bucket
+	vector<unsigned long long> hashes;	//every group's hash
+
+	unsigned long long hashRow(int row) {
+		size_t hash = 0;
+		for(int k = 0; k < spec->keyCols.size(); k++) {
+			int col = spec->keyCols[k];
+			if(spec->intCols[col]) {
+				boost::hash_combine(hash, spec->getInt(col, row));
+			} else {
+				boost::string_ref cell = spec->getView(col, row);
+				boost::hash_combine(hash, boost::hash_range(cell.begin(), cell.end()));
+			}
+		}
+		return Helpers::spreadHash(hash);
+	}
+
+	int bucketOf(unsigned long long hash) {
+		return (int)(hash >> 32) & (head.size() - 1);
+	}
+
+	bool sameKey(int a, int b) {
+		for(int k = 0; k < spec->keyCols.size(); k++) {
+			int col = spec->keyCols[k];
+			if(spec->intCols[col] ? spec->getInt(col, a) != spec->getInt(col, b) : spec->getView(col, a) != spec->getView(col, b)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	int findGroup(unsigned long long hash, int row) {
+		//the group of row, -1 if it has none yet
+		for(int g = head[bucketOf(hash)]; g >= 0; g = next[g]) {
+			if(hashes[g] == hash && sameKey(firstRows[g], row)) {
+				return g;
+			}
+		}
+		return -1;
+	}
+
+	int newGroup(unsigned long long hash, int row) {
+		//adds the group of row to the hash table, its aggregates are up to the caller
+		if(size() >= head.size()) {
+			rehash(head.size() * 2);
+		}
+		int g = size();
+		firstRows.push_back(row);
+		hashes.push_back(hash);
+		next.push_back(head[bucketOf(hash)]);
+		head[bucketOf(hash)] = g;
+		return g;
+	}
+
+	void rehash(int buckets) {
+		head.assign(buckets, -1);
+		for(int g = 0; g < size(); g++) {
+			next[g] = head[bucketOf(hashes[g])];
+			head[bucketOf(hashes[g])] = g;
+		}
+	}
+
+	long initialValue(int a, int row) {
+		//aggregate a over row alone
+		int col = spec->aggCols[a];
+		if(col < 0) {
+			return 0;
+		}
+		return (spec->intCols[col] ? spec->getInt(col, row) : row);
+	}
+
+	long combine(int a, long x, long y) {
+		//aggregate a over the rows of x and then those of y
+		switch(spec->functions[a]) {
+			case SumAgg:
+			case AvgAgg:
+				return x + y;
+			case MinAgg:
+				return (compareValues(a, y, x) < 0 ? y : x);
+			case MaxAgg:
+				return (compareValues(a, y, x) > 0 ? y : x);
+			default:
+				return 0;
+		}
+	}
+
+	bool isInt(int a) {
+		//whether aggregate a's values are numbers rather than rows
+		return spec->aggCols[a] < 0 || spec->intCols[spec->aggCols[a]];
+	}
+
+	int compareValues(int a, long x, long y) {
+		if(isInt(a)) {
+			return (x < y ? -1 : (x > y ? 1 : 0));
+		}
+		return spec->getView(spec->aggCols[a], x).compare(spec->getView(spec->aggCols[a], y));
+	}
+};
+
+#endif
@@ -3,32 +3,147 @@
   
 #include <string>
 #include <algorithm>
+#include <map>
+#include <set>
+#include <cstring>
+#include <cstdio>
+#include <boost/utility/string_ref.hpp>
 #include "DataType.h"
+#include "Symbols.h"
+#include "PackedInts.h"
 
 
 using namespace std;
 
 //TODO: extrapolate definitions to .cpp 
+//A column's cells live in one of these representations:
+//	short VARCHAR(n) (n <= INLINE_MAX_LENGTH): inline, one fixed stride slot of n+1 chars per row
+//		(a length byte then the characters) in inlineData, no heap allocation per cell
+//	longer VARCHAR: string arena, the characters of every row appended to arenaBytes and
+//		arenaSpans[row] saying where they are
+//	VARCHAR with few distinct values: dictionary encoded, every distinct value is stored
+//		once in dictionary and each row only holds its code
+//	INTEGER, once loaded or written: frame of reference + bitpacked (packedInts), or run
+//		length encoded (runs) when the column has long runs of equal values
+//	INTEGER, otherwise: one string per row in cells
+//Always go through getView/getElement/addCell/setElement instead of touching the storage directly.
+//Every column also keeps a zone map per block of ZONE_ROWS rows (the smallest and largest value
+//in the block), so scans can skip blocks no row of which can pass a selection.
+const int INLINE_MAX_LENGTH = 32;
+const int DICT_MAX_CARDINALITY = 65536;
+const int VIEW_BUFFERS = 4; //views getView(index) gives of packed INTEGER cells stay valid for this many calls
+const int CELL_BUFFER_SIZE = 12; //a printed int, sign and terminator included
+const int ZONE_ROWS = 65536; //rows per zone map block, a multiple of the scan batch size
+
+struct ArenaSpan{
+	unsigned int start;
+	unsigned int length;
+};
+
+struct ZoneMap{
+	//bounds of one block: minInt/maxInt for INTEGER columns, minStr/maxStr for VARCHAR
+	int minInt;
+	int maxInt;
+	string minStr;
+	string maxStr;
+};
+
+int leadingInt(boost::string_ref cell) {
+	//INTEGER cell as a number, same as atoi without the copy
+	int value = 0;
+	int i = 0;
+	bool negative = (cell.size() > 0 && cell[0] == '-');
+	if(negative) {
+		i++;
+	}
+	for(; i < cell.size() && cell[i] >= '0' && cell[i] <= '9'; i++) {
+		value = value * 10 + (cell[i] - '0');
+	}
+	return (negative ? -value : value);
+}
+
+int compareInts(int x, int y) {
+	return (x < y ? -1 : (x > y ? 1 : 0));
+}
+
+int compareCells(boost::string_ref x, boost::string_ref y, bool isInt) {
+	//<0, 0 or >0 as cell x sorts before, with or after y: INTEGER cells as ints
+	return (isInt ? compareInts(leadingInt(x), leadingInt(y)) : x.compare(y));
+}
+
 class Attribute {
 
 public:
 
 	DataType type;
 	string name;
+	int nameId; //symbol id of name
 	vector<string> cells;
+	bool loaded; //false while the cells are still only on disk (see DBEngine::LoadColumns)
+	bool encoded; //true: rows are codes into dictionary
+	vector<string> dictionary;
+	vector<int> codes;
+	map<string, int> dictCodes; //value -> code
+	bool inlined; //true: rows are slots in inlineData (unless encoded)
+	int stride; //bytes per inline slot
+	vector<char> inlineData;
+	bool arenaStored; //true: rows are spans of arenaBytes (unless encoded)
+	vector<char> arenaBytes; //append-only, overwritten in place only by values that fit
+	vector<ArenaSpan> arenaSpans;
+	bool packed; //true: rows are in packedInts
+	BitPackedInts packedInts;
+	bool runLength; //true: rows are in runs
+	RunLengthInts runs;
+	vector<ZoneMap> zones; //one per ZONE_ROWS rows; bounds may be loose after an update, never too tight
+	bool zonesStale; //true once rows moved between blocks (erased), until buildZones
+	int changes; //bumped whenever an existing row changes or rows move, appending doesn't count
 
-	Attribute() {}
+	Attribute() {
+		nameId = NO_SYMBOL;
+		loaded = true;
+		encoded = false;
+		inlined = false;
+		stride = 0;
+		arenaStored = false;
+		packed = false;
+		runLength = false;
+		zonesStale = false;
+		changes = 0;
+		nextViewBuffer = 0;
+	}
 	
 	Attribute(string input_name, DataType inputType) {
 		name = input_name;
+		nameId = symbols().intern(name);
 		type = inputType;
+		loaded = true;
+		encoded = false;
+		inlined = (!type.isInt() && type.size() > 0 && type.size() <= INLINE_MAX_LENGTH);
+		stride = type.size() + 1;
+		arenaStored = (!type.isInt() && !inlined);
+		packed = false;
+		runLength = false;
+		zonesStale = false;
+		changes = 0;
+		nextViewBuffer = 0;
 	}
 	
 	//Probably a rare case use of this constructor
 	Attribute(string input_name, DataType input_type, vector<string> input_cells) {
 		name = input_name;
+		nameId = symbols().intern(name);
 		type = input_type;
 		cells = input_cells;
+		loaded = true;
+		encoded = false;
+		inlined = false;
+		stride = 0;
+		arenaStored = false;
+		packed = false;
+		runLength = false;
+		zonesStale = false;
+		changes = 0;
+		nextViewBuffer = 0;
 	}
 	
 	string getName() {
@@ -37,37 +152,268 @@ public:
 	
 	void setName(string input_name) {
 		name = input_name;
+		nameId = symbols().intern(name);
 	}
 	
-	void addCell(string value) {
-		cells.push_back(value);
+	bool fits(boost::string_ref value) {
+		//false if value is longer than the declared VARCHAR length
+		return type.isInt() || value.size() <= type.size();
+	}
+	
+	void addCell(boost::string_ref value) {
+		//value must not point into this column's own storage
+		widenZone(getSize(), value);
+		if(encoded) {
+			codes.push_back(getCode(value.to_string(), true));
+		} else if(inlined && value.size() < stride) {
+			inlineData.resize(inlineData.size() + stride);
+			writeSlot(getSize() - 1, value);
+		} else if(inlined || arenaStored) {
+			spill();
+			ArenaSpan span;
+			span.start = arenaBytes.size();
+			span.length = value.size();
+			arenaBytes.insert(arenaBytes.end(), value.begin(), value.end());
+			arenaSpans.push_back(span);
+		} else if(packed || runLength) {
+			int v;
+			if(canonicalInt(value, v) && (runLength || packedInts.fits(v))) {
+				if(packed) {
+					packedInts.push_back(v);
+				} else {
+					runs.push_back(v);
+				}
+			} else {
+				unpack();
+				cells.push_back(value.to_string());
+			}
+		} else {
+			cells.push_back(value.to_string());
+		}
+	}
+	
+	void clear() {
+		//drops every row, keeping the representation (and the dictionary)
+		cells.clear();
+		codes.clear();
+		inlineData.clear();
+		arenaBytes.clear();
+		arenaSpans.clear();
+		packedInts.clear();
+		runs.clear();
+		zones.clear();
+		zonesStale = false;
+		changes++;
+	}
+	
+	void reserve(int rows, long bytes = 0) {
+		//bytes: expected total characters, used to size the string arena
+		if(inlined) {
+			inlineData.reserve(rows * stride);
+		} else if(arenaStored) {
+			arenaSpans.reserve(rows);
+			arenaBytes.reserve(bytes);
+		} else if(!packed && !runLength) {
+			cells.reserve(rows);
+		}
 	}
 	
 	int findCellIndex(string value) {
-		int i = 0;
-		for(vector<string>::iterator iter = cells.begin(); iter != find(cells.begin(), cells.end(), value); iter++) {
-			i++;
+		for(int i = 0; i < getSize(); i++) {
+			if(getView(i) == value) {
+				return i;
+			}
 		}
-		return i;
+		return getSize();
 	}
 	
-	string getElement(int index) {
+	boost::string_ref getView(int index) {
+		//valid until the column is next modified. A compressed INTEGER cell is printed into one of
+		//VIEW_BUFFERS buffers of the column, reused round robin, so that view is overwritten a few calls
+		//later: code that keeps views, or runs on more than one thread, passes its own buffer instead.
+		if(packed || runLength) {
+			char* buffer = viewBuffers[nextViewBuffer];
+			nextViewBuffer = (nextViewBuffer + 1) % VIEW_BUFFERS;
+			return getView(index, buffer);
+		}
+		return getView(index, 0);
+	}
+	
+	boost::string_ref getView(int index, char* buffer) {
+		//same as getView(index), but a compressed INTEGER cell is printed into buffer (CELL_BUFFER_SIZE
+		//bytes), so its view lasts as long as the caller's buffer
+		if(encoded) {
+			return dictionary[codes[index]];
+		}
+		if(inlined) {
+			const char* slot = &inlineData[index * stride];
+			return boost::string_ref(slot + 1, (unsigned char)slot[0]);
+		}
+		if(arenaStored) {
+			const ArenaSpan& span = arenaSpans[index];
+			return (span.length == 0 ? boost::string_ref() : boost::string_ref(&arenaBytes[span.start], span.length));
+		}
+		if(packed || runLength) {
+			int length = sprintf(buffer, "%d", getInt(index));
+			return boost::string_ref(buffer, length);
+		}
 		return cells[index];
 	}
 	
-	void setElement(int spot, string value) {
-		cells[spot] = value;
+	string getElement(int index) {
+		return getView(index).to_string();
+	}
+	
+	int getInt(int index) {
+		//INTEGER cell as a number, same as atoi on getElement without the copy
+		if(packed) {
+			return packedInts.get(index);
+		}
+		if(runLength) {
+			return runs.get(index);
+		}
+		return leadingInt(getView(index));
+	}
+	
+	int compareRows(int a, int b) {
+		//<0, 0 or >0 as row a's cell sorts before, with or after row b's: INTEGER cells as ints
+		return (isInt() ? compareInts(getInt(a), getInt(b)) : getView(a).compare(getView(b)));
+	}
+	
+	void setElement(int spot, boost::string_ref value) {
+		changes++;
+		if(spot / ZONE_ROWS < zones.size()) {
+			widenZone(spot, value);
+		}
+		if(encoded) {
+			codes[spot] = getCode(value.to_string(), true);
+		} else if(inlined && value.size() < stride) {
+			writeSlot(spot, value);
+		} else if(inlined || arenaStored) {
+			spill();
+			ArenaSpan& span = arenaSpans[spot];
+			if(value.size() > span.length) {
+				span.start = arenaBytes.size();
+				arenaBytes.insert(arenaBytes.end(), value.begin(), value.end());
+			} else if(value.size() > 0) {
+				memcpy(&arenaBytes[span.start], value.data(), value.size());
+			}
+			span.length = value.size();
+		} else {
+			int v;
+			if(packed && canonicalInt(value, v) && packedInts.fits(v)) {
+				packedInts.set(spot, v);
+				return;
+			}
+			unpack();
+			cells[spot] = value.to_string();
+		}
+	}
+	
+	void eraseCell(int index) {
+		zonesStale = true;
+		changes++;
+		if(encoded) {
+			codes.erase(codes.begin() + index);
+		} else if(inlined) {
+			inlineData.erase(inlineData.begin() + index * stride, inlineData.begin() + (index + 1) * stride);
+		} else if(arenaStored) {
+			arenaSpans.erase(arenaSpans.begin() + index);
+		} else {
+			unpack();
+			cells.erase(cells.begin() + index);
+		}
 	}
 	
 	int getSize() {
+		if(encoded) {
+			return codes.size();
+		}
+		if(inlined) {
+			return inlineData.size() / stride;
+		}
+		if(arenaStored) {
+			return arenaSpans.size();
+		}
+		if(packed) {
+			return packedInts.count;
+		}
+		if(runLength) {
+			return runs.size();
+		}
 		return cells.size();
 	}
 	
+	int getCode(const string& value, bool add) {
+		//code of value in the dictionary, -1 if it is not there (and add is false)
+		map<string, int>::iterator it = dictCodes.find(value);
+		if(it != dictCodes.end()) {
+			return it->second;
+		}
+		if(!add) {
+			return -1;
+		}
+		dictionary.push_back(value);
+		dictCodes[value] = dictionary.size() - 1;
+		return dictionary.size() - 1;
+	}
+	
+	void encode() {
+		if(encoded) {
+			return;
+		}
+		vector<int> newCodes;
+		newCodes.reserve(getSize());
+		for(int i = 0; i < getSize(); i++) {
+			newCodes.push_back(getCode(getView(i).to_string(), true));
+		}
+		codes.swap(newCodes);
+		encoded = true;
+		vector<string>().swap(cells);
+		vector<char>().swap(inlineData);
+		vector<char>().swap(arenaBytes);
+		vector<ArenaSpan>().swap(arenaSpans);
+	}
+	
+	void decode() {
+		if(!encoded) {
+			return;
+		}
+		vector<int> oldCodes;
+		oldCodes.swap(codes);
+		encoded = false;
+		reserve(oldCodes.size());
+		for(int i = 0; i < oldCodes.size(); i++) {
+			addCell(dictionary[oldCodes[i]]);
+		}
+		vector<string>().swap(dictionary);
+		dictCodes.clear();
+	}
+	
+	void chooseEncoding() {
+		//dictionary encode VARCHAR columns whose values repeat on average at least twice
+		if(type.isInt()) {
+			choosePacking();
+			return;
+		}
+		if(encoded || getSize() < 2) {
+			return;
+		}
+		set<boost::string_ref> distinct;
+		for(int i = 0; i < getSize(); i++) {
+			distinct.insert(getView(i));
+			if(distinct.size() > DICT_MAX_CARDINALITY || distinct.size() * 2 > getSize()) {
+				return;
+			}
+		}
+		encode();
+	}
+	
 	bool hasRepeats() {
 		bool repeat = false;
-		for(int i = 0; i < cells.size(); i++) {
-			for(int j = 0; j < cells.size(); j++) {
-				if(i != j && strcmp(cells[i].c_str(), cells[j].c_str()) == 0) {
+		for(int i = 0; i < getSize(); i++) {
+			for(int j = 0; j < getSize(); j++) {
+				if(i != j && getView(i) == getView(j)) {
 					repeat = true;
 					return repeat;
 				}				
@@ -76,8 +422,75 @@ public:
 		return repeat;
 	}
 	
+	void choosePacking() {
+		//INTEGER columns: run length encode if runs average 4+ rows, else bitpack.
+		//Left alone if a cell isn't exactly a printed int (packing would change it).
+		if(packed || runLength || cells.empty()) {
+			return;
+		}
+		vector<int> values;
+		values.reserve(cells.size());
+		int runCount = 0;
+		for(int i = 0; i < cells.size(); i++) {
+			int v;
+			if(!canonicalInt(cells[i], v)) {
+				return;
+			}
+			if(i == 0 || v != values.back()) {
+				runCount++;
+			}
+			values.push_back(v);
+		}
+		if(runCount * 4 <= values.size()) {
+			runLength = true;
+			for(int i = 0; i < values.size(); i++) {
+				runs.push_back(values[i]);
+			}
+		} else {
+			packed = true;
+			packedInts.pack(values);
+		}
+		vector<string>().swap(cells);
+	}
+	
+	void unpack() {
+		//back to one string per row, before a change the packed form can't hold
+		if(!packed && !runLength) {
+			return;
+		}
+		vector<string> unpacked;
+		unpacked.reserve(getSize() + 1);
+		for(int i = 0; i < getSize(); i++) {
+			unpacked.push_back(intToString(getInt(i)));
+		}
+		packed = false;
+		runLength = false;
+		packedInts.clear();
+		runs.clear();
+		cells.swap(unpacked);
+	}
+	
+	void buildZones() {
+		//recomputes every block's exact bounds
+		zones.clear();
+		zonesStale = false;
+		for(int i = 0; i < getSize(); i++) {
+			if(type.isInt()) {
+				widenIntZone(i, getInt(i));
+			} else {
+				widenZone(i, getView(i));
+			}
+		}
+	}
+	
+	void refreshZones() {
+		if(zonesStale || zones.size() != (getSize() + ZONE_ROWS - 1) / ZONE_ROWS) {
+			buildZones();
+		}
+	}
+	
 	void setElementByName(string old_value, string new_value) {
-		cells[findCellIndex(old_value)] = new_value;
+		setElement(findCellIndex(old_value), new_value);
 	}
 
 	string getType() {
@@ -92,6 +505,76 @@ public:
 		cout << "Name:\t" << name << '\t' << "Datatype:\t" << getType() << '\n';
 	}
 
+private:
+	char viewBuffers[VIEW_BUFFERS][12];
+	int nextViewBuffer;
+	
+	void widenZone(int row, boost::string_ref value) {
+		//grows the bounds of row's block to include value, starting a new block at its first row
+		if(type.isInt()) {
+			widenIntZone(row, leadingInt(value));
+			return;
+		}
+		int block = row / ZONE_ROWS;
+		if(zonesStale || block > zones.size() || (block == zones.size() && row % ZONE_ROWS != 0)) {
+			return; //earlier blocks have no zone yet, refreshZones builds them all
+		}
+		if(block == zones.size()) {
+			zones.push_back(ZoneMap());
+			zones.back().minStr = value.to_string();
+			zones.back().maxStr = zones.back().minStr;
+			return;
+		}
+		ZoneMap& zone = zones[block];
+		if(value < boost::string_ref(zone.minStr)) {
+			zone.minStr = value.to_string();
+		} else if(value > boost::string_ref(zone.maxStr)) {
+			zone.maxStr = value.to_string();
+		}
+	}
+	
+	void widenIntZone(int row, int value) {
+		int block = row / ZONE_ROWS;
+		if(zonesStale || block > zones.size() || (block == zones.size() && row % ZONE_ROWS != 0)) {
+			return;
+		}
+		if(block == zones.size()) {
+			zones.push_back(ZoneMap());
+			zones.back().minInt = value;
+			zones.back().maxInt = value;
+			return;
+		}
+		ZoneMap& zone = zones[block];
+		zone.minInt = min(zone.minInt, value);
+		zone.maxInt = max(zone.maxInt, value);
+	}
+	
+	void writeSlot(int index, boost::string_ref value) {
+		char* slot = &inlineData[index * stride];
+		slot[0] = (char)value.size();
+		memcpy(slot + 1, value.data(), value.size());
+	}
+	
+	void spill() {
+		//a value too long for the inline slots: move every row to the string arena
+		if(!inlined) {
+			return;
+		}
+		int rows = getSize();
+		arenaSpans.reserve(rows + 1);
+		for(int i = 0; i < rows; i++) {
+			const char* slot = &inlineData[i * stride];
+			ArenaSpan span;
+			span.start = arenaBytes.size();
+			span.length = (unsigned char)slot[0];
+			arenaBytes.insert(arenaBytes.end(), slot + 1, slot + 1 + span.length);
+			arenaSpans.push_back(span);
+		}
+		inlined = false;
+		arenaStored = true;
+		vector<char>().swap(inlineData);
+	}
+
 };
 
 #endif
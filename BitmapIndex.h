@@ -0,0 +1,268 @@
+#ifndef BITMAPINDEX_H
+#define BITMAPINDEX_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <boost/cstdint.hpp>
+#include "Attribute.h"
+
+using namespace std;
+
+//Bitmap indexes (CREATE BITMAP INDEX name ON relation (attribute)): for a low cardinality
+//column, the set of rows holding each distinct value, so conditions over several such columns
+//are answered by ANDing and ORing row sets instead of reading cells.
+//Row sets are roaring bitmaps: rows are split by their high 16 bits into containers, each a
+//sorted array of the low 16 bits while it is sparse and a 65536 bit bitset once it is dense.
+
+const int BITMAP_MAX_VALUES = 1024;		//CREATE BITMAP INDEX refuses columns with more distinct values
+const int ROARING_ARRAY_MAX = 4096;		//an array container holding more values becomes a bitset
+const int ROARING_BITSET_WORDS = 1024;	//65536 bits
+
+int popCount(boost::uint64_t word) {
+	int count = 0;
+	for(; word != 0; word &= word - 1) {
+		count++;
+	}
+	return count;
+}
+
+class RoaringBitmap{
+public:
+	struct Container{
+		int key;							//high 16 bits of the rows in it
+		int cardinality;
+		vector<unsigned short> values;		//array container: sorted low 16 bits
+		vector<boost::uint64_t> bits;		//bitset container: ROARING_BITSET_WORDS words, empty for arrays
+
+		bool isBitset() const {
+			return !bits.empty();
+		}
+	};
+	vector<Container> containers;	//sorted by key
+
+	void add(int row) {
+		int key = row >> 16;
+		unsigned short low = (unsigned short)(row & 0xffff);
+		Container& c = findOrAdd(key);
+		if(c.isBitset()) {
+			boost::uint64_t bit = (boost::uint64_t)1 << (low & 63);
+			if((c.bits[low >> 6] & bit) == 0) {
+				c.bits[low >> 6] |= bit;
+				c.cardinality++;
+			}
+			return;
+		}
+		if(c.values.empty() || c.values.back() < low) {
+			c.values.push_back(low); //rows usually arrive in order
+		} else {
+			vector<unsigned short>::iterator it = lower_bound(c.values.begin(), c.values.end(), low);
+			if(*it == low) {
+				return;
+			}
+			c.values.insert(it, low);
+		}
+		c.cardinality++;
+		if(c.cardinality > ROARING_ARRAY_MAX) {
+			c.bits = toBits(c);
+			vector<unsigned short>().swap(c.values);
+		}
+	}
+
+	int size() const {
+		int count = 0;
+		for(int i = 0; i < containers.size(); i++) {
+			count += containers[i].cardinality;
+		}
+		return count;
+	}
+
+	void rows(vector<int>& out) const {
+		//every row, ascending
+		for(int i = 0; i < containers.size(); i++) {
+			const Container& c = containers[i];
+			int high = c.key << 16;
+			if(c.isBitset()) {
+				for(int w = 0; w < ROARING_BITSET_WORDS; w++) {
+					for(boost::uint64_t word = c.bits[w]; word != 0; word &= word - 1) {
+						out.push_back(high | (w << 6) | lowestBit(word));
+					}
+				}
+			} else {
+				for(int j = 0; j < c.values.size(); j++) {
+					out.push_back(high | c.values[j]);
+				}
+			}
+		}
+	}
+
+	RoaringBitmap intersect(const RoaringBitmap& other) const {
+		RoaringBitmap out;
+		int i = 0, j = 0;
+		while(i < containers.size() && j < other.containers.size()) {
+			const Container& a = containers[i];
+			const Container& b = other.containers[j];
+			if(a.key < b.key) {
+				i++;
+			} else if(b.key < a.key) {
+				j++;
+			} else {
+				Container c;
+				c.key = a.key;
+				if(!a.isBitset() && !b.isBitset()) {
+					set_intersection(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(), back_inserter(c.values));
+					c.cardinality = c.values.size();
+				} else {
+					c.bits = toBits(a);
+					vector<boost::uint64_t> bBits = toBits(b);
+					for(int w = 0; w < ROARING_BITSET_WORDS; w++) {
+						c.bits[w] &= bBits[w];
+					}
+					normalize(c);
+				}
+				if(c.cardinality > 0) {
+					out.containers.push_back(c);
+				}
+				i++;
+				j++;
+			}
+		}
+		return out;
+	}
+
+	RoaringBitmap unite(const RoaringBitmap& other) const {
+		RoaringBitmap out;
+		int i = 0, j = 0;
+		while(i < containers.size() || j < other.containers.size()) {
+			if(j == other.containers.size() || (i < containers.size() && containers[i].key < other.containers[j].key)) {
+				out.containers.push_back(containers[i++]);
+			} else if(i == containers.size() || other.containers[j].key < containers[i].key) {
+				out.containers.push_back(other.containers[j++]);
+			} else {
+				const Container& a = containers[i++];
+				const Container& b = other.containers[j++];
+				Container c;
+				c.key = a.key;
+				if(!a.isBitset() && !b.isBitset() && a.cardinality + b.cardinality <= ROARING_ARRAY_MAX) {
+					set_union(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(), back_inserter(c.values));
+					c.cardinality = c.values.size();
+				} else {
+					c.bits = toBits(a);
+					vector<boost::uint64_t> bBits = toBits(b);
+					for(int w = 0; w < ROARING_BITSET_WORDS; w++) {
+						c.bits[w] |= bBits[w];
+					}
+					normalize(c);
+				}
+				out.containers.push_back(c);
+			}
+		}
+		return out;
+	}
+
+private:
+	Container& findOrAdd(int key) {
+		if(!containers.empty() && containers.back().key == key) {
+			return containers.back();
+		}
+		int pos = 0;
+		while(pos < containers.size() && containers[pos].key < key) {
+			pos++;
+		}
+		if(pos == containers.size() || containers[pos].key != key) {
+			Container c;
+			c.key = key;
+			c.cardinality = 0;
+			containers.insert(containers.begin() + pos, c);
+		}
+		return containers[pos];
+	}
+
+	static vector<boost::uint64_t> toBits(const Container& c) {
+		if(c.isBitset()) {
+			return c.bits;
+		}
+		vector<boost::uint64_t> bits(ROARING_BITSET_WORDS, 0);
+		for(int i = 0; i < c.values.size(); i++) {
+			bits[c.values[i] >> 6] |= (boost::uint64_t)1 << (c.values[i] & 63);
+		}
+		return bits;
+	}
+
+	static void normalize(Container& c) {
+		//c.bits were just computed: recount, and go back to an array if it is sparse again
+		c.cardinality = 0;
+		for(int w = 0; w < ROARING_BITSET_WORDS; w++) {
+			c.cardinality += popCount(c.bits[w]);
+		}
+		if(c.cardinality > ROARING_ARRAY_MAX) {
+			return;
+		}
+		c.values.clear();
+		for(int w = 0; w < ROARING_BITSET_WORDS; w++) {
+			for(boost::uint64_t word = c.bits[w]; word != 0; word &= word - 1) {
+				c.values.push_back((unsigned short)((w << 6) | lowestBit(word)));
+			}
+		}
+		vector<boost::uint64_t>().swap(c.bits);
+	}
+
+	static int lowestBit(boost::uint64_t word) {
+		return popCount((word & (~word + 1)) - 1);
+	}
+};
+
+class BitmapIndex{
+//Keyed by each row's text (getView), so INTEGER and VARCHAR columns compare their keys
+//exactly the way Comparison compares their cells.
+public:
+	string name;
+	int attrId;			//symbol id of the indexed attribute
+	bool isInt;
+	map<string, RoaringBitmap> bitmaps;	//value -> rows holding it
+	int indexedRows;	//rows 0..indexedRows-1 of the column are in the bitmaps
+	int builtChanges;	//the column's changes count the bitmaps are up to date with
+
+	BitmapIndex(string Name, Attribute& column) {
+		name = Name;
+		attrId = column.nameId;
+		isInt = column.isInt();
+		indexedRows = 0;
+		builtChanges = column.changes;
+	}
+
+	void refresh(Attribute& column) {
+		//catches up with the column: appended rows are added, any other change rebuilds the bitmaps
+		if(column.changes != builtChanges || indexedRows > column.getSize()) {
+			bitmaps.clear();
+			indexedRows = 0;
+			builtChanges = column.changes;
+		}
+		for(; indexedRows < column.getSize(); indexedRows++) {
+			bitmaps[column.getElement(indexedRows)].add(indexedRows);
+		}
+	}
+
+	void add(const string& key, int row) {
+		bitmaps[key].add(row);
+		indexedRows = max(indexedRows, row + 1);
+	}
+
+	string stringify() {
+		//"BITMAP <name> <attribute> <entries>", then "row key" per row, value by value
+		string out;
+		int entries = 0;
+		for(map<string, RoaringBitmap>::iterator it = bitmaps.begin(); it != bitmaps.end(); ++it) {
+			vector<int> rows;
+			it->second.rows(rows);
+			for(int i = 0; i < rows.size(); i++) {
+				out += intToString(rows[i]) + " " + it->first + "\n";
+			}
+			entries += rows.size();
+		}
+		return "BITMAP " + name + " " + symbols().name(attrId) + " " + intToString(entries) + "\n" + out;
+	}
+};
+
+#endif
@@ -1,15 +1,33 @@
 #ifndef CONDCONJCOMPOP_H
 #define CONDCONJCOMPOP_H
 
+#include <set>
 #include "Relation.h"
 #include "Helpers.h"
+#include "Symbols.h"
 
-enum Operation { Equality=0, NonEquality, LessThanEqual, GreaterThanEqual, LessThan, GreaterThan}; // ==, !=, <, >, <=, >=
+enum Operation { Equality=0, NonEquality, LessThanEqual, GreaterThanEqual, LessThan, GreaterThan, Prefix}; // ==, !=, <, >, <=, >=, ^=
+//a ^= b: a starts with b. Compared as text, INTEGER attributes by their printed digits
 
 class Operand{
 public:
 	bool isAttribute;
 	string val; //either attribute name or literal
+	int nameId; //attribute symbol id, interned when the condition is parsed/built
+	int colIndex; //set by bind(), position of the attribute in the input's schema
+	int ival; //set by bind(), integer value of an INTEGER literal
+	Operand(){
+		isAttribute = false;
+		nameId = NO_SYMBOL;
+		colIndex = -1;
+		ival = 0;
+	}
+	bool bind(vector<int>& nameIds);
+	void attributes(set<string>& names){
+		if(isAttribute){
+			names.insert(val);
+		}
+	}
 };
 
 
@@ -17,16 +35,29 @@ class Condition;
 class Conjunction;
 class Comparison;
 
+//passes(relation, tupleIndex) looks attributes up by name on every call.
+//For scans, bind() the condition to the input's schema (as symbol ids) once, then use
+//passes(relation, colMap, tupleIndex), where colMap maps schema positions to relation->columns.
 class Condition{
 public:
 	vector<Conjunction> conjunctions;
 	bool passes(Relation* relation, int tupleIndex);
+	bool bind(vector<int>& nameIds, vector<DataType>& types);
+	bool passes(Relation* relation, vector<int>& colMap, int tupleIndex);
+	bool blockMayPass(Relation* relation, vector<int>& colMap, int block);
+	bool bitmapRows(Relation* relation, vector<int>& colMap, RoaringBitmap& rows, bool& exact);
+	void attributes(set<string>& names);
 };
 
 class Conjunction{
 public:
 	vector<Comparison> comparisons;
 	bool passes(Relation* relation, int tupleIndex);
+	bool bind(vector<int>& nameIds, vector<DataType>& types);
+	bool passes(Relation* relation, vector<int>& colMap, int tupleIndex);
+	bool blockMayPass(Relation* relation, vector<int>& colMap, int block);
+	bool bitmapRows(Relation* relation, vector<int>& colMap, RoaringBitmap& rows, bool& exact);
+	void attributes(set<string>& names);
 };
 
 class Comparison{
@@ -36,9 +67,108 @@ public:
 	Operand operand1;
 	Operation op;
 	Operand operand2;
+	bool intFlag; //set by bind()
+	Attribute* dictColumn; //dictionary encoded column literalCode was looked up in
+	int literalCode; //code of the literal in dictColumn's dictionary, -1 if it is not there
+	Attribute* runColumn; //run length encoded column runResult was worked out for
+	int runIndex; //the run
+	bool runResult; //whether the rows of that run pass
+	Comparison(){
+		isCondition = false;
+		intFlag = false;
+		dictColumn = 0;
+		literalCode = -1;
+		runColumn = 0;
+		runIndex = 0;
+		runResult = false;
+	}
+	bool passesPacked(Attribute& column, int tupleIndex);
 	bool passes(Relation* relation, int tupleIndex);
+	bool bind(vector<int>& nameIds, vector<DataType>& types);
+	bool passes(Relation* relation, vector<int>& colMap, int tupleIndex);
+	bool blockMayPass(Relation* relation, vector<int>& colMap, int block);
+	bool bitmapRows(Relation* relation, vector<int>& colMap, RoaringBitmap& rows, bool& exact);
+	void attributes(set<string>& names);
 };
 
+template <class T>
+bool hasPrefix(const T&, const T&){
+	return false; //only text has prefixes
+}
+
+bool hasPrefix(const boost::string_ref& val, const boost::string_ref& prefix){
+	return val.starts_with(prefix);
+}
+
+template <class T>
+bool applyOp(Operation op, const T& val1, const T& val2){
+	switch (op){
+		case Equality:
+			return val1==val2;
+		case NonEquality:
+			return val1!=val2;
+		case LessThanEqual:
+			return val1<=val2;
+		case GreaterThanEqual:
+			return val1>=val2;
+		case LessThan:
+			return val1<val2;
+		case GreaterThan:
+			return val1>val2;
+		case Prefix:
+			return hasPrefix(val1, val2);
+	}
+	return false;
+}
+
+template <class T>
+bool prefixMayPass(const T&, const T&, const T&){
+	return true;
+}
+
+bool prefixMayPass(const boost::string_ref& minVal, const boost::string_ref& maxVal, const boost::string_ref& prefix){
+	//the values starting with prefix are a contiguous range from prefix up
+	return maxVal>=prefix && minVal.substr(0, prefix.size())<=prefix;
+}
+
+template <class T>
+bool rangeMayPass(Operation op, const T& minVal, const T& maxVal, const T& literal){
+	//whether some value between minVal and maxVal can satisfy "value op literal"
+	switch (op){
+		case Equality:
+			return minVal<=literal && literal<=maxVal;
+		case NonEquality:
+			return !(minVal==literal && maxVal==literal);
+		case LessThanEqual:
+			return minVal<=literal;
+		case GreaterThanEqual:
+			return maxVal>=literal;
+		case LessThan:
+			return minVal<literal;
+		case GreaterThan:
+			return maxVal>literal;
+		case Prefix:
+			return prefixMayPass(minVal, maxVal, literal);
+	}
+	return true;
+}
+
+Operation mirrorOp(Operation op){
+	//literal op attribute is attribute mirrorOp(op) literal
+	switch (op){
+		case LessThanEqual:
+			return GreaterThanEqual;
+		case GreaterThanEqual:
+			return LessThanEqual;
+		case LessThan:
+			return GreaterThan;
+		case GreaterThan:
+			return LessThan;
+		default:
+			return op;
+	}
+}
+
 bool Condition::passes(Relation* relation, int tupleIndex){ //only 1 conjuntion must pass for condition to be true
 	for(int i =0; i<conjunctions.size(); i++){
 			if(conjunctions[i].passes(relation, tupleIndex)){
@@ -66,14 +196,14 @@ bool Comparison::passes(Relation* relation, int tupleIndex){
 		int ival1, ival2;
 		string val1, val2;
 		if(operand1.isAttribute){
-			intFlag = relation->findAttribute(operand1.val).type.isInt();
-			val1=relation->findAttribute(operand1.val).cells[tupleIndex];
+			intFlag = relation->findAttributeP(operand1.val)->type.isInt() && op!=Prefix;
+			val1=relation->findAttributeP(operand1.val)->getElement(tupleIndex);
 			if(intFlag) ival1=Helpers::stringToInt(val1);
 		}else{
 			val1=operand1.val;
 		}
 		if(operand2.isAttribute){
-			val2=relation->findAttribute(operand2.val).cells[tupleIndex];
+			val2=relation->findAttributeP(operand2.val)->getElement(tupleIndex);
 		}else{
 			val2=operand2.val;
 			if(intFlag) ival2=Helpers::stringToInt(val2);
@@ -98,6 +228,9 @@ bool Comparison::passes(Relation* relation, int tupleIndex){
 				case 5:
 					return val1>val2;
 					break;
+				case 6:
+					return val1.compare(0, val2.size(), val2)==0;
+					break;
 			}
 		}else{
 			switch (op){
@@ -119,11 +252,282 @@ bool Comparison::passes(Relation* relation, int tupleIndex){
 				case 5:
 					return ival1>ival2;
 					break;
+				default:
+					return false; //Prefix compares text, never intFlag
 			}
 		}
 	}
 }
 
 
-#endif
+bool Operand::bind(vector<int>& nameIds){
+	if(!isAttribute){
+		return true;
+	}
+	for(int i=0; i<nameIds.size(); i++){
+		if(nameIds[i]==nameId){
+			colIndex=i;
+			return true;
+		}
+	}
+	return false; //no such attribute
+}
 
+bool Condition::bind(vector<int>& nameIds, vector<DataType>& types){
+	for(int i =0; i<conjunctions.size(); i++){
+		if(!conjunctions[i].bind(nameIds, types)){
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Conjunction::bind(vector<int>& nameIds, vector<DataType>& types){
+	for(int i =0; i<comparisons.size(); i++){
+		if(!comparisons[i].bind(nameIds, types)){
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Comparison::bind(vector<int>& nameIds, vector<DataType>& types){
+	if(isCondition){
+		return cond.bind(nameIds, types);
+	}
+	if(!operand1.bind(nameIds) || !operand2.bind(nameIds)){
+		return false;
+	}
+	//compare as integers if either side is an INTEGER attribute (prefixes are always text)
+	intFlag=false;
+	dictColumn=0;
+	runColumn=0;
+	if(op==Prefix){
+		intFlag=false;
+	}else if(operand1.isAttribute){
+		intFlag=types[operand1.colIndex].isInt();
+	}else if(operand2.isAttribute){
+		intFlag=types[operand2.colIndex].isInt();
+	}
+	if(intFlag){
+		operand1.ival=atoi(operand1.val.c_str());
+		operand2.ival=atoi(operand2.val.c_str());
+	}
+	return true;
+}
+
+void Condition::attributes(set<string>& names){
+	//every attribute name the condition reads
+	for(int i =0; i<conjunctions.size(); i++){
+		conjunctions[i].attributes(names);
+	}
+}
+
+void Conjunction::attributes(set<string>& names){
+	for(int i =0; i<comparisons.size(); i++){
+		comparisons[i].attributes(names);
+	}
+}
+
+void Comparison::attributes(set<string>& names){
+	if(isCondition){
+		cond.attributes(names);
+	}else{
+		operand1.attributes(names);
+		operand2.attributes(names);
+	}
+}
+
+bool Condition::passes(Relation* relation, vector<int>& colMap, int tupleIndex){
+	for(int i =0; i<conjunctions.size(); i++){
+		if(conjunctions[i].passes(relation, colMap, tupleIndex)){
+			return true;
+		}
+	}
+	return false;
+}
+
+bool Conjunction::passes(Relation* relation, vector<int>& colMap, int tupleIndex){
+	for(int i =0; i<comparisons.size(); i++){
+		if( !(comparisons[i].passes(relation, colMap, tupleIndex)) ){
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Comparison::passes(Relation* relation, vector<int>& colMap, int tupleIndex){
+	if(isCondition){
+		return cond.passes(relation, colMap, tupleIndex);
+	}
+	if(intFlag){
+		if(operand1.isAttribute!=operand2.isAttribute){
+			Attribute& column = relation->columns[colMap[(operand1.isAttribute ? operand1 : operand2).colIndex]];
+			if(column.packed || column.runLength){
+				return passesPacked(column, tupleIndex);
+			}
+		}
+		int ival1 = operand1.ival;
+		int ival2 = operand2.ival;
+		if(operand1.isAttribute){
+			ival1=relation->columns[colMap[operand1.colIndex]].getInt(tupleIndex);
+		}
+		if(operand2.isAttribute){
+			ival2=relation->columns[colMap[operand2.colIndex]].getInt(tupleIndex);
+		}
+		return applyOp(op, ival1, ival2);
+	}
+	if((op==Equality || op==NonEquality) && operand1.isAttribute!=operand2.isAttribute){
+		//attribute == literal on a dictionary encoded column: compare codes, not strings
+		Operand& attr = (operand1.isAttribute ? operand1 : operand2);
+		Attribute& column = relation->columns[colMap[attr.colIndex]];
+		if(column.encoded){
+			if(dictColumn!=&column){
+				dictColumn=&column;
+				literalCode=column.getCode((operand1.isAttribute ? operand2 : operand1).val, false);
+			}
+			return applyOp(op, column.codes[tupleIndex], literalCode);
+		}
+	}
+	//views: inline VARCHAR cells compare with memcmp, without building strings
+	char buffer1[CELL_BUFFER_SIZE];
+	char buffer2[CELL_BUFFER_SIZE];
+	boost::string_ref val1 = (operand1.isAttribute ? relation->columns[colMap[operand1.colIndex]].getView(tupleIndex, buffer1) : boost::string_ref(operand1.val));
+	boost::string_ref val2 = (operand2.isAttribute ? relation->columns[colMap[operand2.colIndex]].getView(tupleIndex, buffer2) : boost::string_ref(operand2.val));
+	return applyOp(op, val1, val2);
+}
+
+bool Comparison::passesPacked(Attribute& column, int tupleIndex){
+	//attribute op literal on a compressed INTEGER column, evaluated without unpacking the row
+	long long literal = (operand1.isAttribute ? operand2.ival : operand1.ival);
+	if(column.packed){
+		//compare the stored offset with the literal moved into the column's frame of reference
+		long long code = (long long)column.packedInts.code(tupleIndex);
+		long long shifted = literal - column.packedInts.base;
+		return (operand1.isAttribute ? applyOp(op, code, shifted) : applyOp(op, shifted, code));
+	}
+	//run length: decided once per run
+	RunLengthInts& runs = column.runs;
+	if(runColumn!=&column || tupleIndex>=runs.ends[runIndex] || (runIndex>0 && tupleIndex<runs.ends[runIndex-1])){
+		runColumn = &column;
+		runIndex = runs.run(tupleIndex);
+		long long value = runs.values[runIndex];
+		runResult = (operand1.isAttribute ? applyOp(op, value, literal) : applyOp(op, literal, value));
+	}
+	return runResult;
+}
+
+//Zone map pruning: blockMayPass(relation, colMap, block) is false only if no row of that
+//ZONE_ROWS block can pass, judged from the block's min/max. Comparisons it can't judge
+//(attribute vs attribute, columns without zones) say true.
+bool Condition::blockMayPass(Relation* relation, vector<int>& colMap, int block){
+	for(int i =0; i<conjunctions.size(); i++){
+		if(conjunctions[i].blockMayPass(relation, colMap, block)){
+			return true;
+		}
+	}
+	return false;
+}
+
+bool Conjunction::blockMayPass(Relation* relation, vector<int>& colMap, int block){
+	for(int i =0; i<comparisons.size(); i++){
+		if( !(comparisons[i].blockMayPass(relation, colMap, block)) ){
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Comparison::blockMayPass(Relation* relation, vector<int>& colMap, int block){
+	if(isCondition){
+		return cond.blockMayPass(relation, colMap, block);
+	}
+	if(operand1.isAttribute==operand2.isAttribute || (op==Prefix && !operand1.isAttribute)){
+		return true;
+	}
+	Operand& attr = (operand1.isAttribute ? operand1 : operand2);
+	Operand& literal = (operand1.isAttribute ? operand2 : operand1);
+	Attribute& column = relation->columns[colMap[attr.colIndex]];
+	if(column.zonesStale || block>=column.zones.size() || (column.isInt() && !intFlag)){
+		return true; //INTEGER zones have no text bounds for ^=
+	}
+	ZoneMap& zone = column.zones[block];
+	Operation attrOp = (operand1.isAttribute ? op : mirrorOp(op));
+	if(intFlag){
+		return rangeMayPass(attrOp, zone.minInt, zone.maxInt, literal.ival);
+	}
+	return rangeMayPass(attrOp, boost::string_ref(zone.minStr), boost::string_ref(zone.maxStr), boost::string_ref(literal.val));
+}
+
+//Bitmap indexes: bitmapRows(relation, colMap, rows, exact) is false if bitmap indexes can't
+//narrow the rows down at all. Otherwise rows holds every row that can pass, and exact says
+//whether they all do (every comparison was answered from bitmaps, none left to check).
+bool Condition::bitmapRows(Relation* relation, vector<int>& colMap, RoaringBitmap& rows, bool& exact){
+	//every conjunction has to be narrowed, one that isn't could let any row pass
+	exact = true;
+	for(int i =0; i<conjunctions.size(); i++){
+		RoaringBitmap conjRows;
+		bool conjExact;
+		if(!conjunctions[i].bitmapRows(relation, colMap, conjRows, conjExact)){
+			return false;
+		}
+		rows = (i==0 ? conjRows : rows.unite(conjRows));
+		exact = exact && conjExact;
+	}
+	return !conjunctions.empty();
+}
+
+bool Conjunction::bitmapRows(Relation* relation, vector<int>& colMap, RoaringBitmap& rows, bool& exact){
+	//any comparison that can be answered narrows the conjunction
+	bool narrowed = false;
+	exact = true;
+	for(int i =0; i<comparisons.size(); i++){
+		RoaringBitmap compRows;
+		bool compExact;
+		if(!comparisons[i].bitmapRows(relation, colMap, compRows, compExact)){
+			exact = false;
+			continue;
+		}
+		rows = (narrowed ? rows.intersect(compRows) : compRows);
+		narrowed = true;
+		exact = exact && compExact;
+	}
+	return narrowed;
+}
+
+bool Comparison::bitmapRows(Relation* relation, vector<int>& colMap, RoaringBitmap& rows, bool& exact){
+	if(isCondition){
+		return cond.bitmapRows(relation, colMap, rows, exact);
+	}
+	if(operand1.isAttribute==operand2.isAttribute){
+		return false;
+	}
+	Operand& attr = (operand1.isAttribute ? operand1 : operand2);
+	Operand& literal = (operand1.isAttribute ? operand2 : operand1);
+	Attribute& column = relation->columns[colMap[attr.colIndex]];
+	BitmapIndex* index = relation->findBitmapIndex(column.nameId);
+	if(index==0){
+		return false;
+	}
+	index->refresh(column);
+	//low cardinality: the comparison is worked out once per distinct value
+	rows = RoaringBitmap();
+	for(map<string, RoaringBitmap>::iterator it = index->bitmaps.begin(); it != index->bitmaps.end(); ++it){
+		bool passes;
+		if(intFlag){
+			int value = leadingInt(it->first);
+			passes = (operand1.isAttribute ? applyOp(op, value, literal.ival) : applyOp(op, literal.ival, value));
+		}else{
+			boost::string_ref value(it->first);
+			boost::string_ref lit(literal.val);
+			passes = (operand1.isAttribute ? applyOp(op, value, lit) : applyOp(op, lit, value));
+		}
+		if(passes){
+			rows = rows.unite(it->second);
+		}
+	}
+	exact = true;
+	return true;
+}
+
+#endif
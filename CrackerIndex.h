@@ -0,0 +1,91 @@
+#ifndef CRACKERINDEX_H
+#define CRACKERINDEX_H
+
+#include <vector>
+#include <map>
+#include <algorithm>
+#include "Attribute.h"
+
+using namespace std;
+
+//Adaptive indexes (SET CRACKING ON): instead of being built up front, an INTEGER column's
+//cracker index is a copy of the column that every range selection on it partitions a little
+//further ("cracks") around the selection's bounds. After a crack the rows of the range sit
+//next to each other, and later selections only partition the pieces their bounds fall in,
+//so a column that keeps being queried converges toward a sorted, fully indexed one.
+
+class CrackerIndex{
+public:
+	int attrId;				//symbol id of the cracked attribute
+	vector<int> values;		//the column's values, partitioned by cuts
+	vector<int> rows;		//row each value came from
+	map<long long, int> cuts;	//bound -> first position whose value is >= bound, every value before it is < bound
+	int builtChanges;		//the column's changes count the copy is up to date with
+
+	CrackerIndex(Attribute& column) {
+		attrId = column.nameId;
+		builtChanges = column.changes;
+	}
+
+	void refresh(Attribute& column) {
+		//any change to the column, appends included, starts over from a fresh uncracked copy
+		if(column.changes == builtChanges && values.size() == column.getSize()) {
+			return;
+		}
+		values.clear();
+		rows.clear();
+		cuts.clear();
+		values.reserve(column.getSize());
+		rows.reserve(column.getSize());
+		for(int i = 0; i < column.getSize(); i++) {
+			values.push_back(column.getInt(i));
+			rows.push_back(i);
+		}
+		builtChanges = column.changes;
+	}
+
+	bool range(long long low, long long high, int limit, vector<int>& out, int& cracked) {
+		//rows whose value is in [low, high), in row order, cracking the column at both bounds
+		//(cracked counts the pieces that had to be partitioned). False, with out left empty,
+		//if more than limit rows match
+		int start = crack(low, cracked);
+		int end = crack(max(low, high), cracked);
+		if(end - start > limit) {
+			return false;
+		}
+		out.assign(rows.begin() + start, rows.begin() + end);
+		sort(out.begin(), out.end());
+		return true;
+	}
+
+private:
+	int crack(long long bound, int& cracked) {
+		//position of bound, partitioning the one piece it falls in if it isn't a cut yet
+		map<long long, int>::iterator next = cuts.lower_bound(bound);
+		if(next != cuts.end() && next->first == bound) {
+			return next->second;
+		}
+		int end = (next == cuts.end() ? (int)values.size() : next->second);
+		int start = 0;
+		if(next != cuts.begin()) {
+			map<long long, int>::iterator previous = next;
+			start = (--previous)->second;
+		}
+		int i = start;
+		int j = end - 1;
+		while(i <= j) {
+			if(values[i] < bound) {
+				i++;
+			} else {
+				swap(values[i], values[j]);
+				swap(rows[i], rows[j]);
+				j--;
+			}
+		}
+		cuts[bound] = i;
+		cracked++;
+		return i;
+	}
+};
+
+#endif
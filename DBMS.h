@@ -20,7 +20,14 @@
 #include "Attribute.h"
 #include "Relation.h"
 #include "CondConjCompOp.h"
+#include "QueryPlan.h"
+#include "Operators.h"
 #include<boost/tokenizer.hpp>
+//Query builder calls taking a brace list of attribute names, .project({"id", "s"}), need C++11
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1800)
+#define QUERY_INITIALIZER_LISTS
+#include <initializer_list>
+#endif
 //#include "DBEngine.h"
 //TODO: Determine if we need all headers
 
@@ -30,6 +37,11 @@ using namespace std;
 class DBMS;
 class DBEngine;
 class ParserEngine;
+class ExecEngine;
+class Query;
+class Cursor;
+
+const int INDEX_FILE_VERSION = 1; //of the .idx files DBEngine writes, older ones are rebuilt
 
 //Class Method forward declarations 
 class DBMS{
@@ -38,14 +50,16 @@ class DBMS{
 //to interact with their underlying engine without going through the user interface of the DBMS.
 //http://en.wikipedia.org/wiki/Database_management_system
 public:
-	map<string,Relation*> relsInMem;
-	vector<Relation*> scratchRels;
+	map<int,Relation*> relsInMem; //keyed by relation name symbol id
 	ParserEngine* Parser;
 	DBEngine* dbEngine; //IDEA: low priority, Could easily build in support for multiple Databases. i.e. map<name,DBEngine*> myDBs, managing paths for each one
+	ExecEngine* execEngine;
+	TaskPool* pool; //worker threads shared by every parallel operation, SET THREADS n resizes it
 	string DBPath;
 	DBMS(bool CmdPrmptMode, int DebugMode, string DBPath);
 	Relation readFromFile(string input);
 	void Execute(string line);
+	Query from(string relationName);
 	int ExecuteTxtFile(string fileName);
 	~DBMS();
 	
@@ -72,10 +86,22 @@ public:
 	bool UpdateRelation(Relation* rel); //aka OverWriteExistingRelation()
 	bool WriteNewRelation(Relation* newRel);
 	bool RelationFileExists(string relName);
+	string filePath(string relName);
 	bool Delete(string relationName, vector<int> indices);
 	bool Update(string relationName, vector< pair<string,string> > AttributeNameNewValueList, vector<int> indices);
 	Relation* readFromFilePtr(string input);
+	Relation* readHeaderPtr(string relationName);
+	void readZonesPtr(Relation* rel, ifstream& inputFile);
+	void readIndexesPtr(Relation* rel);
+	string indexPath(string relName);
+	bool CreateIndex(string indexName, string relationName, string attributeName);
+	bool CreateBitmapIndex(string indexName, string relationName, string attributeName);
 	bool OpenRelation(string relationName);
+	Relation* GetRelation(string relationName);
+	Relation* GetRelation(string relationName, bool allCols, set<string> cols);
+	Relation* GetRelation(int relId, bool allCols, set<string> cols);
+	bool LoadColumns(Relation* rel, bool allCols, set<string> cols);
+	void LoadColumnSection(Relation* rel, int col);
 	Relation readFromFile(string input);
 };
 
@@ -85,6 +111,7 @@ public:
 	int debug;
 	DBMS* ownerDBMS;
 	vector<string> sToks;
+	vector<int> sIds; //symbol id of each token, NO_SYMBOL for anything never interned (e.g. literals)
 	int sI;
 	int level;
 	ParserEngine(DBMS* OwnerDBMS, int Debug);
@@ -99,8 +126,8 @@ public:
 	bool ParseTokens();
 	
 private:
-	Relation* doProduct();
 	string getRelationName(int* relS);
+	bool valuesFit(Relation* rel, vector<string>& tuple);
 	Relation* doUpdate(int* upStart);
 	string getLiteral(int* litS);
 	string getAttributeName(int* attS);
@@ -109,21 +136,34 @@ private:
 	Operation getOp(int* opI);
 	Operand getOperand(int* opandI);
 	Condition getCondition(int* conS);
-	Relation* doSelect(int* selStart);
-	Relation* doExpr(int* qStart);
+	PlanPtr getSelection(int* selStart);
+	PlanPtr getExpr(int* qStart);
 	bool isProjection1(int pS);
-	Relation* doProjection(int* pS);
-	Relation* doAtomicExpr(int* aeStart);
-	Relation* doRename(int* qStart);
+	PlanPtr getProjection(int* pS);
+	PlanPtr getAtomicExpr(int* aeStart);
+	PlanPtr getRenaming(int* qStart);
+	PlanPtr getOrdering(int* qStart);
+	PlanPtr getLimiting(int* qStart);
+	PlanPtr getGrouping(int* qStart);
+	vector<AggregateCall> getAggregateList(int* aggListS);
 	vector<string> getAttributeList(int* attrListS);
 	vector<string> dbTokens(string commandLine);
+	void scan(const string& line);
+	void foldCase(int i);
+	int upperSymbol(int i);
 	//Syntatic Grammar Functions:
 	bool isAtomicExpr();
 	bool isQuery();
 	bool isSelection();
 	bool isRenaming();
+	bool isOrdering();
+	bool isLimiting();
+	bool isGrouping();
+	bool isAggregateList();
+	bool isAggregate();
 	bool isUnion();
 	bool isProduct();
+	bool isJoin();
 	bool isDifference();
 	bool isExpr();
 	bool isRelationName();
@@ -146,7 +186,9 @@ private:
 	bool isWrite();
 	bool isExit();
 	bool isShow();
+	bool isSet();
 	bool isCreate();
+	bool isCreateIndex();
 	bool isUpdate();
 	bool isInsert();
 	bool isDelete();
@@ -158,12 +200,94 @@ private:
 	void spaces(int local_level);
 };
 
+class ExecEngine{
+//Runs query plans built by the ParserEngine or the query builder as a tree of
+//pull-based Operators (see Operators.h).
+public:
+	DBMS* ownerDBMS;
+	int debug;
+	QueryStats lastStats; //of the most recently completed query
+	bool cracking; //SET CRACKING ON: selections build and crack cracker indexes (see CrackerIndex.h)
+	long sortMemory; //SET SORT MEMORY: bytes of cells an ordering holds before it spills sorted runs to disk
+	ExecEngine(DBMS* OwnerDBMS, int Debug);
+	Relation* Execute(PlanNode* plan, string resultName);
+	Cursor Open(PlanNode* plan);
+	Operator* buildOperator(PlanNode* plan, QueryArena* arena);
+	void finishQuery(QueryArena* arena);
+private:
+	Operator* doScan(PlanNode* plan);
+	Operator* doJoin(PlanNode* plan, Operator* left, Operator* right);
+	void requireColumns(PlanNode* plan, bool allCols, set<string> cols);
+};
+
+class Cursor{
+//Forward-only view over a query result, for callers embedding the DBMS:
+//	Cursor c = dbms.from("dvds").where(col("dvdId") == id).run();
+//	while(c.next()){ cout<<c.get("title"); }
+//Tuples are pulled from the operator tree as the cursor advances; nothing is materialized.
+public:
+	Cursor(Operator* Root, boost::shared_ptr<QueryArena> Arena, ExecEngine* Engine);
+	bool next();
+	string get(string attrName);
+	string get(int col);
+	vector<string> getTuple();
+	vector<string> getNames();
+	void print();
+private:
+	boost::shared_ptr<QueryArena> arena; //declared before root so it outlives the operators
+	boost::shared_ptr<Operator> root;
+	ExecEngine* engine;
+	void finish();
+	Batch batch;
+	int row;
+	bool opened;
+	bool done;
+	bool failed;	//the query could not run: no such relation, or open() failed
+};
+
+class Query{
+//In-process query builder. Builds the same plan tree the ParserEngine does, without
+//formatting, scanning or parsing any text.
+public:
+	Query(DBMS* OwnerDBMS, PlanPtr Plan);
+	Query& where(Condition cond);
+	Query& project(vector<string> attrList);
+	Query& project(string attrList);
+	Query& rename(vector<string> attrList);
+	Query& rename(string attrList);
+	Query& orderBy(vector<string> attrList);
+	Query& orderBy(string attrList);
+	Query& limit(int count);
+	Query& groupBy(vector<string> attrList, vector<AggregateCall> aggs);
+	Query& groupBy(string attrList, vector<AggregateCall> aggs);
+	Query& groupBy(string attrList, AggregateCall agg);
+#ifdef QUERY_INITIALIZER_LISTS
+	//without these, {"id", "s"} converts to a vector and to a string (as an iterator range) equally well
+	Query& project(initializer_list<string> attrList);
+	Query& rename(initializer_list<string> attrList);
+	Query& orderBy(initializer_list<string> attrList);
+	Query& groupBy(initializer_list<string> attrList, vector<AggregateCall> aggs);
+	Query& groupBy(initializer_list<string> attrList, AggregateCall agg);
+#endif
+	Query& product(Query right);
+	Query& join(Query right, string leftAttr, string rightAttr);
+	Query& unionWith(Query right);
+	Query& difference(Query right);
+	PlanPtr getPlan();
+	Cursor run();
+private:
+	DBMS* ownerDBMS;
+	PlanPtr plan;
+};
+
 
 DBMS::DBMS(bool CmdPrmptMode=true, int DebugMode=1, string DBPath="./"){
 	debug = DebugMode;
 	consoleMode = CmdPrmptMode;
+	pool = new TaskPool(1);
 	dbEngine = new DBEngine(DBPath, this);
 	Parser = new ParserEngine(this, DebugMode);
+	execEngine = new ExecEngine(this, DebugMode);
 	if(consoleMode){
 		startConsole();
 	}
@@ -217,26 +341,27 @@ void DBMS::Execute(string line){
 	}else if(valid==2){
 		Relation* newRel = Parser->ExecuteQuery(line);
 		//TODO: look here \/
-		//if newRel == 0, errOut
 		//if (relsInMem.count(newRel->getName())==1){not a new rel, already in mem. handle differntly or updatre relsInMem? errOut if addr is not same?}
-
+		if(newRel==0){errOut("Unexpected error Executing Query: "+line); return;}
 		
 		//NOTE: breaks if returned relation does not have a name
 		string newRelName = newRel->getName();
-		relsInMem[newRel->getName()]=newRel;
+		relsInMem[newRel->nameId]=newRel;
 	}
 }
+Query DBMS::from(string relationName){
+	return Query(this, makeScanPlan(relationName));
+}
 bool DBMS::freeMemory(){
 	if(debug>=3){cout<<"Freeing Memory:\n-Relations:\n";}
-	for( map<string,Relation*>::iterator relIt= relsInMem.begin(); relIt != relsInMem.end(); ++relIt){
-		if(debug>=3){cout<<"--"<<(*relIt).first<<" @ "<<relIt->second<<endl;}
+	for( map<int,Relation*>::iterator relIt= relsInMem.begin(); relIt != relsInMem.end(); ++relIt){
+		if(debug>=3){cout<<"--"<<symbols().name((*relIt).first)<<" @ "<<relIt->second<<endl;}
 		delete relIt->second;
 	}
-	for( int i=0; i<scratchRels.size(); i++){
-		delete scratchRels[i];
-	}
 	delete dbEngine;
 	delete Parser;
+	delete execEngine;
+	delete pool;
 	return true; // is there any way to tell if memory was freed or if failed?
 }	
 void DBMS::startConsole(){
@@ -272,6 +397,7 @@ int DBMS::ExecuteTxtFile(string fileName){
 		//get next line and print, skip if blank line
 		getline(inFile, line);
 		if(line=="" || line=="\r\n" || line=="\n"){continue;} //Skip blank Lines
+		if(line.compare(0, 2, "//")==0){continue;} //Skip comments (expected output, see dbmsMainTest)
 		
 		int valid = Parser->Validate(line);
 		cout<<"********\n"<<line<<"\nvalid:"<<valid<<endl;
@@ -284,13 +410,12 @@ int DBMS::ExecuteTxtFile(string fileName){
 		}else if(valid==2){
 			Relation* newRel = Parser->ExecuteQuery(line);
 			//TODO: look here \/
-			//if newRel == 0, errOut
 			//if (relsInMem.count(newRel->getName())==1){not a new rel, already in mem. handle differntly or updatre relsInMem? errOut if addr is not same?}
-
+			if(newRel==0){errOut("Unexpected error Executing Query: "+line); continue;}
 			
 			//NOTE: breaks if returned relation does not have a name
 			string newRelName = newRel->getName();
-			relsInMem[newRel->getName()]=newRel;
+			relsInMem[newRel->nameId]=newRel;
 		}else{
 			throw "UNKNOWN EXCEPTION source code: 1233";
 		}
@@ -334,12 +459,39 @@ void DBEngine::writeToFile(string relationName) {
 //*need differentiation of write vs overwrite.
 //*needs error handling (return false if file not found (or if it is found, it depends on the case) ) See below.
 //QUESTION: will we be reading/writing Attributes aswell, or just Relations?
-	string filename = relationName + ".db";
+	Relation* rel = GetRelation(relationName); //every column has to be in memory before the file is replaced
+	if(rel==0){
+		return;
+	}
+	string filename = filePath(relationName);
 	
 	ofstream outputFile;
-	outputFile.open(filename.c_str());
-	outputFile << ownerDBMS->relsInMem[relationName]->stringify();
+	outputFile.open(filename.c_str(), ios::out | ios::binary); //binary: the column offsets count bytes
+	outputFile << rel->stringifyColumns(ownerDBMS->pool);
 	outputFile.close();
+	PrimaryKeyIndex* primary = rel->findPrimaryIndex();
+	if(primary!=0 || !rel->secondaryIndexes.empty() || !rel->bitmapIndexes.empty()){
+		//"IDX <version> <height> <checksum>" ties the indexes to the file just written, see readIndexesPtr
+		ofstream indexFile(indexPath(relationName).c_str(), ios::out | ios::binary);
+		indexFile << "IDX " << INDEX_FILE_VERSION << " " << rel->getHeight() << " " << rel->fileChecksum << "\n";
+		if(primary!=0){
+			primary->refresh(rel->primaryKeyColumns());
+			indexFile << primary->stringify();
+		}
+		for(int i=0; i<rel->secondaryIndexes.size(); i++){
+			SecondaryIndex& index = rel->secondaryIndexes[i];
+			index.refresh(rel->columns[rel->columnIndex(index.attrId)]);
+			indexFile << index.stringify();
+		}
+		for(int i=0; i<rel->bitmapIndexes.size(); i++){
+			BitmapIndex& index = rel->bitmapIndexes[i];
+			index.refresh(rel->columns[rel->columnIndex(index.attrId)]);
+			indexFile << index.stringify();
+		}
+		indexFile.close();
+	}else{
+		remove(indexPath(relationName).c_str()); //indexes of a relation this one replaced
+	}
 	
 }
 bool DBEngine::UpdateRelation(Relation* rel){ //aka OverWriteExistingRelation()
@@ -357,8 +509,68 @@ bool DBEngine::WriteNewRelation(Relation* newRel){
 bool DBEngine::RelationFileExists(string relName){
 	//returns true if file @ dbPath+"//"+relName+".db"  exists
 	//otherwise returns false
-	return false;
-
+	ifstream relFile(filePath(relName).c_str());
+	return relFile.good();
+}
+string DBEngine::filePath(string relName){
+	return dbFilePath + relName + ".db";
+}
+string DBEngine::indexPath(string relName){
+	//secondary indexes of relName, next to its .db file
+	return dbFilePath + relName + ".idx";
+}
+bool DBEngine::CreateBitmapIndex(string indexName, string relationName, string attributeName){
+	//builds a bitmap per distinct value of attributeName, which must have at most BITMAP_MAX_VALUES
+	set<string> cols;
+	cols.insert(attributeName);
+	Relation* rel = GetRelation(relationName, false, cols);
+	if(rel==0){
+		cerr<<"****| ERROR |**| Relation "<<relationName<<" does not exist |****"<<endl;
+		return false;
+	}
+	int col = rel->columnIndex(symbols().find(attributeName));
+	if(col==-1){
+		cerr<<"****| ERROR |**| Relation "<<relationName<<" has no attribute "<<attributeName<<" |****"<<endl;
+		return false;
+	}
+	for(int i=0; i<rel->bitmapIndexes.size(); i++){
+		if(rel->bitmapIndexes[i].name==indexName){
+			cerr<<"****| ERROR |**| Index "<<indexName<<" already exists on "<<relationName<<" |****"<<endl;
+			return false;
+		}
+	}
+	BitmapIndex index(indexName, rel->columns[col]);
+	index.refresh(rel->columns[col]);
+	if(index.bitmaps.size()>BITMAP_MAX_VALUES){
+		cerr<<"****| ERROR |**| "<<attributeName<<" has too many distinct values for a bitmap index |****"<<endl;
+		return false;
+	}
+	rel->bitmapIndexes.push_back(index);
+	return true;
+}
+bool DBEngine::CreateIndex(string indexName, string relationName, string attributeName){
+	//builds a B+tree over attributeName; written to relationName.idx with the relation
+	set<string> cols;
+	cols.insert(attributeName);
+	Relation* rel = GetRelation(relationName, false, cols);
+	if(rel==0){
+		cerr<<"****| ERROR |**| Relation "<<relationName<<" does not exist |****"<<endl;
+		return false;
+	}
+	int col = rel->columnIndex(symbols().find(attributeName));
+	if(col==-1){
+		cerr<<"****| ERROR |**| Relation "<<relationName<<" has no attribute "<<attributeName<<" |****"<<endl;
+		return false;
+	}
+	for(int i=0; i<rel->secondaryIndexes.size(); i++){
+		if(rel->secondaryIndexes[i].name==indexName){
+			cerr<<"****| ERROR |**| Index "<<indexName<<" already exists on "<<relationName<<" |****"<<endl;
+			return false;
+		}
+	}
+	rel->secondaryIndexes.push_back(SecondaryIndex(indexName, rel->columns[col]));
+	rel->secondaryIndexes.back().refresh(rel->columns[col]);
+	return true;
 }
 Relation DBEngine::readFromFile(string input) { //TODO: Not needed, can remove 
 
@@ -387,43 +599,291 @@ Relation DBEngine::readFromFile(string input) { //TODO: Not needed, can remove
 		return importedRelation;
 	}	
 bool DBEngine::OpenRelation(string relationName){
-	if(ownerDBMS->relsInMem.count(relationName)!=0){
-		//relation already exists in memory!
-		cerr<<"<><><>"<<"Relation already exists in memory\n";
+	//queries load relations on first reference, so OPEN only has to make sure every column is in memory.
+	//Opening a relation that is already open is not an error.
+	return GetRelation(relationName)!=0;
+}
+Relation* DBEngine::GetRelation(string relationName){
+	set<string> none;
+	return GetRelation(relationName, true, none);
+}
+Relation* DBEngine::GetRelation(string relationName, bool allCols, set<string> cols){
+	//Relation cache: returns relsInMem[relationName], reading it from its file first if it is not open.
+	//Only columns in cols (or all of them, if allCols) are guaranteed to be loaded.
+	//returns 0 if the relation is neither open nor on disk
+	return GetRelation(symbols().intern(relationName), allCols, cols);
+}
+Relation* DBEngine::GetRelation(int relId, bool allCols, set<string> cols){
+	Relation* rel;
+	if(ownerDBMS->relsInMem.count(relId)!=0){
+		rel = ownerDBMS->relsInMem[relId];
+	}else{
+		rel = readHeaderPtr(symbols().name(relId));
+		if(rel==0){
+			return 0;
+		}
+		ownerDBMS->relsInMem[rel->nameId] = rel;
+	}
+	if(!LoadColumns(rel, allCols, cols)){
+		return 0;
+	}
+	return rel;
+}
+bool DBEngine::LoadColumns(Relation* rel, bool allCols, set<string> cols){
+	//fills the requested columns of rel that are still only on disk.
+	//At least one column is always loaded so the relation has a height.
+	vector<int> toLoad;
+	bool anyLoaded = false;
+	for(int i=0; i<rel->columns.size(); i++){
+		if(rel->columns[i].loaded){
+			anyLoaded = true;
+		}else if(allCols || cols.count(rel->columns[i].name)!=0){
+			toLoad.push_back(i);
+		}
+	}
+	if(toLoad.empty() && !anyLoaded && rel->columns.size()>0){
+		toLoad.push_back(0);
+	}
+	if(toLoad.empty()){
+		return true;
+	}
+	ifstream inputFile(rel->sourceFile.c_str(), ios::in | ios::binary);
+	if(!inputFile.good()){
 		return false;
 	}
-	//TODO: ELSE IF relationName.db does NOT exist, break (return false)
-	else{
-		Relation* readRel = readFromFilePtr(relationName+".db");
-		ownerDBMS->relsInMem.insert( pair<string,Relation*>(relationName,readRel) );
+	string line;
+	if(!rel->columnOffsets.empty()){
+		//columnar file: read just the requested columns' sections, a task per column
+		inputFile.close();
+		TaskGroup group;
+		for(int i=0; i<toLoad.size(); i++){
+			ownerDBMS->pool->submit(group, boost::bind(&DBEngine::LoadColumnSection, this, rel, toLoad[i]));
+		}
+		ownerDBMS->pool->wait(group);
 		return true;
 	}
-	return false;
+	//row file: every line has to be parsed, but only the requested cells are kept
+	getline(inputFile, line); //header
+	while(getline(inputFile, line)){
+		vector<string> cells = rel->parseTupleCells(line);
+		if(cells.size() != rel->columns.size()){
+			continue;
+		}
+		for(int i=0; i<toLoad.size(); i++){
+			rel->columns[toLoad[i]].addCell(cells[toLoad[i]]);
+		}
+	}
+	inputFile.close();
+	for(int i=0; i<toLoad.size(); i++){
+		rel->columns[toLoad[i]].chooseEncoding();
+		rel->columns[toLoad[i]].refreshZones();
+		rel->columns[toLoad[i]].loaded = true;
+	}
+	return true;
 }
-Relation* DBEngine::readFromFilePtr(string input) {
-	ifstream inputFile;
-	inputFile.open(input.c_str());
-	//TODO: if inputFile did not open, return 0!
-	
-	
-	string name = input.substr(0, input.size()-3);
-	
-	Relation* importedRelation= new Relation(name);
-	
-	char currentChar;
-	vector<string> parsedInfo;
+void DBEngine::LoadColumnSection(Relation* rel, int col){
+	//fills column col of rel from its section of rel's columnar file. Touches nothing but that
+	//column, so the sections of different columns can be loaded at the same time
+	ifstream inputFile(rel->sourceFile.c_str(), ios::in | ios::binary);
+	string line;
+	Attribute& column = rel->columns[col];
+	inputFile.seekg(rel->columnOffsets[col]);
+	char kind = rel->sectionKinds[col];
+	if(kind=='F'){
+		//"base bits", then the packed words
+		getline(inputFile, line);
+		BitPackedInts& packed = column.packedInts;
+		stringstream frame(line);
+		frame >> packed.base >> packed.bits;
+		packed.count = rel->fileHeight;
+		packed.words.resize(((long long)packed.count * packed.bits + 63) / 64);
+		if(!packed.words.empty()){
+			inputFile.read((char*)&packed.words[0], packed.words.size() * sizeof(boost::uint64_t));
+		}
+		column.packed = true;
+	}else if(kind=='R'){
+		//number of runs, then "value length" per run
+		getline(inputFile, line);
+		int runCount = atoi(line.c_str());
+		RunLengthInts& runs = column.runs;
+		int value, length;
+		for(int j=0; j<runCount && inputFile >> value >> length; j++){
+			runs.values.push_back(value);
+			runs.ends.push_back(runs.size() + length);
+		}
+		column.runLength = true;
+	}else if(kind=='D'){
+		//dictionary size, dictionary, then one code per row
+		getline(inputFile, line);
+		int dictSize = atoi(line.c_str());
+		column.encoded = true;
+		for(int j=0; j<dictSize && getline(inputFile, line); j++){
+			column.getCode(line, true);
+		}
+		column.codes.reserve(rel->fileHeight);
+		for(int j=0; j<rel->fileHeight && getline(inputFile, line); j++){
+			column.codes.push_back(atoi(line.c_str()));
+		}
+	}else{
+		long sectionBytes = 0;
+		if(col+1 < rel->columnOffsets.size()){
+			sectionBytes = rel->columnOffsets[col+1] - rel->columnOffsets[col];
+		}
+		column.reserve(rel->fileHeight, sectionBytes);
+		for(int j=0; j<rel->fileHeight && getline(inputFile, line); j++){
+			column.addCell(line);
+		}
+		column.chooseEncoding();
+	}
+	column.refreshZones(); //only rebuilt if the file had none
+	column.loaded = true;
+}
+Relation* DBEngine::readHeaderPtr(string relationName) {
+	//reads only the header (and, for columnar files, the column directory) of relationName.db;
+	//the columns are left unloaded for LoadColumns
+	ifstream inputFile(filePath(relationName).c_str(), ios::in | ios::binary);
+	if(!inputFile.good()){
+		return 0;
+	}
 	string line;
-
 	getline(inputFile, line);
-	importedRelation->parseHeader(line);
-	
-	while(!inputFile.eof()) {
+	Relation* rel = new Relation(relationName);
+	rel->parseHeader(line);
+	rel->sourceFile = filePath(relationName);
+	for(int i=0; i<rel->columns.size(); i++){
+		rel->columns[i].loaded = false;
+	}
+	getline(inputFile, line);
+	if(line.compare(0, 9, "COLUMNAR ")==0){
+		stringstream columnar(line.substr(9));
+		columnar >> rel->fileHeight >> rel->fileChecksum;
 		getline(inputFile, line);
-		importedRelation->parseTuples(line);
+		stringstream directory(line);
+		string entry;
+		while(directory >> entry){
+			rel->columnOffsets.push_back(atol(entry.c_str()));
+			char flag = entry[entry.size()-1];
+			rel->sectionKinds.push_back(isdigit(flag) ? 0 : flag);
+		}
+		readZonesPtr(rel, inputFile);
 	}
-	
 	inputFile.close();
+	readIndexesPtr(rel);
+	return rel;
+}
+void DBEngine::readZonesPtr(Relation* rel, ifstream& inputFile){
+	//the zone maps after a columnar file's directory, if it has them and they use this build's block size
+	string line;
+	getline(inputFile, line);
+	if(line.compare(0, 6, "ZONES ")!=0){
+		return;
+	}
+	stringstream sizes(line.substr(6));
+	int blockRows = 0;
+	int blocks = 0;
+	sizes >> blockRows >> blocks;
+	if(blockRows!=ZONE_ROWS){
+		return;
+	}
+	for(int i=0; i<rel->columns.size(); i++){
+		Attribute& column = rel->columns[i];
+		column.zones.resize(blocks);
+		for(int j=0; j<blocks; j++){
+			ZoneMap& zone = column.zones[j];
+			getline(inputFile, zone.minStr);
+			getline(inputFile, zone.maxStr);
+			if(column.isInt()){
+				zone.minInt = atoi(zone.minStr.c_str());
+				zone.maxInt = atoi(zone.maxStr.c_str());
+				zone.minStr.clear();
+				zone.maxStr.clear();
+			}
+		}
+	}
+}
+void DBEngine::readIndexesPtr(Relation* rel){
+	//the indexes in rel's .idx file, if it has one. Their entries are only loaded if the file was
+	//written with rel's file (same version, height and checksum); otherwise just the definitions are,
+	//and the indexes rebuild themselves from the columns when they are first used
+	ifstream indexFile(indexPath(rel->name).c_str(), ios::in | ios::binary);
+	string line;
+	if(!getline(indexFile, line)){
+		return;
+	}
+	stringstream stamp(line);
+	string tag;
+	int version = 0;
+	int height = -1;
+	unsigned int checksum = 0;
+	stamp >> tag >> version >> height >> checksum;
+	bool current = (tag=="IDX" && version==INDEX_FILE_VERSION && height==rel->fileHeight && checksum==rel->fileChecksum);
+	if(tag=="IDX" && !getline(indexFile, line)){
+		return;
+	}
+	do{
+		stringstream definition(line);
+		string keyword;
+		int entries = 0;
+		definition >> keyword;
+		if(keyword=="PRIMARY"){
+			//"PRIMARY <entries> <attribute>..."
+			definition >> entries;
+			vector<string> keyNames;
+			string attrName;
+			while(definition >> attrName){
+				keyNames.push_back(attrName);
+			}
+			if(rel->primaryKeys.empty()){
+				rel->primaryKeys = keyNames;
+			}
+			PrimaryKeyIndex* primary = rel->findPrimaryIndex();
+			for(int i=0; i<entries && getline(indexFile, line); i++){
+				int space = line.find(' ');
+				if(current && primary!=0){
+					primary->add(line.substr(space+1), atoi(line.substr(0, space).c_str()));
+				}
+			}
+			continue;
+		}
+		string indexName, attrName;
+		definition >> indexName >> attrName >> entries;
+		int col = rel->columnIndex(symbols().find(attrName));
+		if(col==-1 || (keyword!="INDEX" && keyword!="BITMAP")){
+			return;
+		}
+		SecondaryIndex index(indexName, rel->columns[col]);
+		BitmapIndex bitmap(indexName, rel->columns[col]);
+		for(int i=0; i<entries && getline(indexFile, line); i++){
+			if(!current){
+				continue;
+			}
+			int space = line.find(' ');
+			int row = atoi(line.substr(0, space).c_str());
+			if(keyword=="INDEX"){
+				index.add(line.substr(space+1), row);
+			}else{
+				bitmap.add(line.substr(space+1), row);
+			}
+		}
+		if(keyword=="INDEX"){
+			rel->secondaryIndexes.push_back(index);
+		}else{
+			rel->bitmapIndexes.push_back(bitmap);
+		}
+	}while(getline(indexFile, line));
+}
+Relation* DBEngine::readFromFilePtr(string input) {
+	//reads every column of relation input ("name.db"), row or columnar layout
+	string name = input.substr(0, input.size()-3);
 	
+	Relation* importedRelation = readHeaderPtr(name);
+	if(importedRelation==0){
+		return 0;
+	}
+	if(!LoadColumns(importedRelation, true, set<string>())){
+		delete importedRelation;
+		return 0;
+	}
 	return importedRelation;
 }
 bool DBEngine::Update(string relationName, vector< pair<string,string> > AttributeNameNewValueList, vector<int> indices){
@@ -488,9 +948,25 @@ ParserEngine::ParserEngine(DBMS* OwnerDBMS, int Debug=1, bool AllowNonCapitalCMD
 }
 void ParserEngine::resetParserVals(){
 	sToks.clear();
+	sIds.clear();
 	sI=0;
 	level=0;
 }
+void ParserEngine::scan(const string& line){
+	//tokens, and their symbol ids for keyword and name matching
+	sToks = dbTokens(line);
+	sIds = findSymbols(sToks);
+}
+void ParserEngine::foldCase(int i){
+	if(allowNonCaps){
+		sToks[i] = Helpers::retUpper(sToks[i]);
+		sIds[i] = symbols().find(sToks[i]);
+	}
+}
+int ParserEngine::upperSymbol(int i){
+	//symbol id token i would have after foldCase
+	return (allowNonCaps ? symbols().find(Helpers::retUpper(sToks[i])) : sIds[i]);
+}
 void ParserEngine::printSTok(){
 		//cout<<"*******Scanner Tokens:\n";
 		for(vector<string>::iterator it=sToks.begin(); it!=sToks.end(); ++it){
@@ -499,7 +975,7 @@ void ParserEngine::printSTok(){
 	}
 int ParserEngine::Validate(const string& line){
 	resetParserVals();
-	sToks= dbTokens(line);
+	scan(line);
 	
 	if(sToks.back() != ";"){
 		return 0;
@@ -509,7 +985,7 @@ int ParserEngine::Validate(const string& line){
 			return 1; //1 represents a valid command
 	}else{
 		resetParserVals();
-		sToks= dbTokens(line);
+		scan(line);
 		//cout<<"stoks.size()"<<sToks.size()<<endl;
 		if(isQuery()){
 			return 2; //2 represents a valid query
@@ -521,16 +997,25 @@ int ParserEngine::Validate(const string& line){
 Relation* ParserEngine::ExecuteQuery(const string& Query){
 	enter("EXECUTEQUERY");
 	resetParserVals();
-	sToks = dbTokens(Query);
+	scan(Query);
 	
 	int queryS=0;
 	string relName = sToks[queryS];
 	queryS+=2;
-	Relation* queryRel = doExpr(&queryS);
-	
-	queryRel->name=relName;
+	PlanPtr plan = getExpr(&queryS);
+	//only the final result is materialized, intermediates stream between operators
+	Relation* queryRel = ownerDBMS->execEngine->Execute(plan.get(), relName);
+	if(queryRel==0){
+		leave("EXECUTEQUERY");
+		return 0;
+	}
 	
-	ownerDBMS->relsInMem[relName] = queryRel;
+	int relId = queryRel->nameId;
+	if(ownerDBMS->relsInMem.count(relId)!=0 && ownerDBMS->relsInMem[relId]!=queryRel){
+		//"a <- select (...) a;" replaces a
+		delete ownerDBMS->relsInMem[relId];
+	}
+	ownerDBMS->relsInMem[relId] = queryRel;
 	leave("EXECUTEQUERY");
 	//TODO: MOVE IN IMPLEMENTATION
 	return queryRel;
@@ -540,8 +1025,36 @@ bool ParserEngine::ExecuteCommand(const string& Command){ //ASSUMES VALID INPUT
 	int tI=0;
 	int* cmdI = &tI;
 	resetParserVals();
-	sToks = dbTokens(Command);
-	if(sToks[tI] == "CREATE"){
+	scan(Command);
+	if(upperSymbol(tI) == KW_SET && upperSymbol(tI+1) == KW_THREADS){
+		//SET THREADS integer, clamped to the range the pool takes
+		int requested = Helpers::stringToInt(sToks[tI+2]);
+		int threads = min(max(1, requested), TaskPool::maxThreads());
+		if(threads != requested){
+			cerr<<"****| ERROR |**| SET THREADS "<<requested<<" is out of range, using "<<threads<<" threads |****"<<endl;
+		}
+		ownerDBMS->pool->resize(threads);
+		return true;
+	}
+	if(upperSymbol(tI) == KW_SET && upperSymbol(tI+1) == KW_SORT){
+		//SET SORT MEMORY integer, in kilobytes
+		ownerDBMS->execEngine->sortMemory = max(1, Helpers::stringToInt(sToks[tI+3])) * 1024L;
+		return true;
+	}
+	if(upperSymbol(tI) == KW_SET){
+		//SET CRACKING ( ON | OFF )
+		ownerDBMS->execEngine->cracking = (upperSymbol(tI+2) == KW_ON);
+		return true;
+	}
+	if(upperSymbol(tI) == KW_CREATE && upperSymbol(tI+1) == KW_BITMAP){
+		//CREATE BITMAP INDEX index-name ON relation-name ( attribute-name )
+		return ownerDBMS->dbEngine->CreateBitmapIndex(sToks[3], sToks[5], sToks[7]);
+	}
+	if(upperSymbol(tI) == KW_CREATE && upperSymbol(tI+1) == KW_INDEX){
+		//CREATE INDEX index-name ON relation-name ( attribute-name )
+		return ownerDBMS->dbEngine->CreateIndex(sToks[2], sToks[4], sToks[6]);
+	}
+	if(sIds[tI] == KW_CREATE){
 		string relName = sToks[2];
 		queue<string> attrNames;
 		queue<int> attrTypes;
@@ -551,26 +1064,26 @@ bool ParserEngine::ExecuteCommand(const string& Command){ //ASSUMES VALID INPUT
 			alI++;
 			attrNames.push(sToks[alI]);
 			alI++;
-			string typeName = sToks[alI];
-			if(typeName=="VARCHAR"){
+			int typeName = sIds[alI];
+			if(typeName==KW_VARCHAR){
 				alI+=2;
 				int len = Helpers::stringToInt(sToks[alI]);
 				attrTypes.push(len);
 				alI+=2;			
-			}else if(typeName=="INTEGER"){
+			}else if(typeName==KW_INTEGER){
 				attrTypes.push(0);
 				alI++;
 			}else{
 				cerr<<"Something terrible happened in ExecuteCommand-Create-TypedAttributeList\n";
 			}
-		}while(sToks[alI]==",");
+		}while(sIds[alI]==SYM_COMMA);
 		alI+=3; //move index to open-paren of 'primary key' attribute-list
 		queue<string> pkNames;
 		do{
 			alI++;
 			pkNames.push(sToks[alI]);
 			alI++;
-		}while(sToks[alI]==",");
+		}while(sIds[alI]==SYM_COMMA);
 		Relation* newRel = new Relation(relName);
 		while(!attrNames.empty()){
 			DataType dt((attrTypes.front()==0?true:false),attrTypes.front());
@@ -582,21 +1095,50 @@ bool ParserEngine::ExecuteCommand(const string& Command){ //ASSUMES VALID INPUT
 			newRel->primaryKeys.push_back(pkNames.front());
 			pkNames.pop();
 		}
-		ownerDBMS->relsInMem.insert( pair<string,Relation*>(relName,newRel) );
+		ownerDBMS->relsInMem.insert( pair<int,Relation*>(newRel->nameId,newRel) );
 		ret = true;
 		return ret;
 	}
-	else if(sToks[tI] == "INSERT"){
+	else if(sIds[tI] == KW_INSERT && symbols().find(Helpers::retUpper(sToks[5]))==KW_RELATION){
+		//INSERT INTO relation-name VALUES FROM RELATION expr
+		string relName = sToks[2];
+		int exprI = 6;
+		PlanPtr plan = getExpr(&exprI);
+		//materialized first, expr may read relName itself
+		Relation* fromRel = ownerDBMS->execEngine->Execute(plan.get(), "insertFrom");
+		Relation* toRel = ownerDBMS->dbEngine->GetRelation(relName);
+		if(fromRel==0 || toRel==0){
+			delete fromRel;
+			return false;
+		}
+		if(fromRel->columns.size()!=toRel->columns.size()){
+			delete fromRel;
+			return false;
+		}
+		for(int i=0; i<fromRel->getHeight(); i++){
+			vector<string> tuple = fromRel->getTuple(i);
+			if(!valuesFit(toRel, tuple)){
+				delete fromRel;
+				return false;
+			}
+		}
+		for(int i=0; i<fromRel->getHeight(); i++){
+			toRel->addTuple(fromRel->getTuple(i));
+		}
+		delete fromRel;
+		return true;
+	}
+	else if(sIds[tI] == KW_INSERT){
 		string relName = sToks[2];
 		vector<string> vals;
 		int intInd=5;
 		do{
 			intInd++;
-			if(sToks[intInd]=="\""){
+			if(sIds[intInd]==SYM_QUOTE){
 				intInd++;
 				vals.push_back(sToks[intInd]);
 				intInd+=2;
-			}else if(sToks[intInd]=="-"){
+			}else if(sIds[intInd]==SYM_MINUS){
 				intInd++;
 				vals.push_back("-"+sToks[intInd]);
 				intInd++;
@@ -604,30 +1146,36 @@ bool ParserEngine::ExecuteCommand(const string& Command){ //ASSUMES VALID INPUT
 				vals.push_back(sToks[intInd]);
 				intInd++;
 			}
-		}while(sToks[intInd]==",");
+		}while(sIds[intInd]==SYM_COMMA);
 		//cout<<"tuple("<<vals.size()<<"):"<<vals[0]<<":"<<vals[1]<<":"<<vals[2]<<endl;
-		ownerDBMS->relsInMem[relName]->addTuple(vals);
+		Relation* toRel = ownerDBMS->dbEngine->GetRelation(relName);
+		if(toRel==0 || !valuesFit(toRel, vals)){
+			return false;
+		}
+		toRel->addTuple(vals);
 		ret=true;
 		return ret;
 	}
-	else if(sToks[tI]=="SHOW"){
-	    string relName=sToks[tI+1];
-	    ownerDBMS->relsInMem[relName]->print();
+	else if(sIds[tI]==KW_SHOW){
+		//show-cmd ::= SHOW atomic-expr
+		int showI = tI+1;
+		PlanPtr plan = getAtomicExpr(&showI);
+		ownerDBMS->execEngine->Open(plan.get()).print();
 	    ret=true;
 	    return ret;
 	}
-	else if(sToks[tI]=="WRITE"){
+	else if(sIds[tI]==KW_WRITE){
 	    string relName=sToks[tI+1];
 	    bool suc = true; // TODO: need new db writing methods to support this
 		ownerDBMS->dbEngine->writeToFile(relName); //TODO: change this when DBEngine writing changes
 	    return suc;
 	}
-	else if(sToks[tI]=="OPEN"){
+	else if(sIds[tI]==KW_OPEN){
 		string relName = sToks[tI+1];
 		bool suc = ownerDBMS->dbEngine->OpenRelation(relName);
 		return suc;
 	}
-	else if(sToks[tI]=="EXIT"){
+	else if(sIds[tI]==KW_EXIT){
 		//bool suc = freeMemory();
 		//TODO: need to fix
 		
@@ -635,18 +1183,23 @@ bool ParserEngine::ExecuteCommand(const string& Command){ //ASSUMES VALID INPUT
 		exit(1);
 		return false;
 	}
-	else if(sToks[tI]=="CLOSE"){
+	else if(sIds[tI]==KW_CLOSE){
 		string relName = sToks[tI+1];
 		bool suc = false; // TODO: need new db writing methods to support this
+		int relId = symbols().find(relName);
+		if(ownerDBMS->relsInMem.count(relId)==0){
+			return suc;
+		}
 		ownerDBMS->dbEngine->writeToFile(relName); //TODO: change this when DBEngine writing changes
-	    suc = (ownerDBMS->relsInMem.erase(relName)==1?true:false);
+		delete ownerDBMS->relsInMem[relId];
+	    suc = (ownerDBMS->relsInMem.erase(relId)==1?true:false);
 		return suc;
 		//delete existing relName.db
 		//write in-memory version of relName to relName.db
 		//free memory of relsInMem[relName] 
 		//remove relName from relsInMem   //int erasedCount = relsInMem.erase(relName); if(erasedCount!=1){errOut("Error removing relName from memory map.");}
 	}
-	else if(sToks[tI]=="DELETE"){
+	else if(sIds[tI]==KW_DELETE){
 	}
 //UPDATE customers SET firstName = "+firstName+" WHERE userId = "+idToUpdate+";
 //UPDATE customers SET lastName = "+lastName+" WHERE userId = "+idToUpdate+";
@@ -654,17 +1207,17 @@ bool ParserEngine::ExecuteCommand(const string& Command){ //ASSUMES VALID INPUT
 //UPDATE dvds SET dvdId = "+dvdId+" WHERE inventoryNumber = "+idToUpdate+";
 //UPDATE dvds SET dvdTitle = "+dvdTitle+" WHERE inventoryNumber = "+idToUpdate+";
 //UPDATE rentals SET checkInDate = \""+checkInDate+"\" WHERE dvdId = "+dvdId+";
-	else if(sToks[tI]=="UPDATE")
+	else if(sIds[tI]==KW_UPDATE)
 	{
 		int upI = (*cmdI);
 		Relation* newRel = doUpdate(&upI);
 		(*cmdI) = upI;
-		return true;
+		return newRel!=0;
 		
 /*		string relName = sToks[2],attribToChange = sToks[4],valToChangeTo,attribForFinding,valToFind; 
 		vector<string> vals;
 		int intInd=6,rowIndex,colIndex;
-		if(sToks[intInd]=="\""){
+		if(sIds[intInd]==SYM_QUOTE){
 			intInd++;
 			valToChangeTo=sToks[intInd];
 			intInd+=3;
@@ -674,7 +1227,7 @@ bool ParserEngine::ExecuteCommand(const string& Command){ //ASSUMES VALID INPUT
 		}
 		attribForFinding=sToks[intInd];
 		intInd+=2;
-		if(sToks[intInd]=="\""){
+		if(sIds[intInd]==SYM_QUOTE){
 			intInd++;
 			valToFind=sToks[intInd];
 		}else{
@@ -706,7 +1259,7 @@ int ParserEngine::ParseProgramBlock(string Program){//TODO: kill off
 }
 bool ParserEngine::ParseSingleLine(string line){//TODO: kill off
 	resetParserVals();
-	sToks=dbTokens(line);	
+	scan(line);	
 		if(debug==1){
 			cout<<endl<<line<<endl;
 		}else if(debug > 1){
@@ -741,7 +1294,7 @@ vector<string> ParserEngine::dbTokens(string commandLine){ //Scanner-Tokenizer
 																//that may have multiple parts and to ensure that text within 
 																//quotations is held together as one token, regardless of 
 																//punctuation or spaces.
-	boost::char_separator<char> separator(" \n","\"()+<>=-;,!");	//the tokenizer function allows for the declaration of ignored and
+	boost::char_separator<char> separator(" \n","\"()+<>=-;,!*^");	//the tokenizer function allows for the declaration of ignored and
 																	//returned symbols with the ignored before the comma
 	vector<string> tokens;	//a vector of type string to store the tokens so they may be returned to the calling program
 	boost::tokenizer< boost::char_separator<char> > possibleTokens(commandLine, separator);	//the boost library supplies this function
@@ -839,8 +1392,8 @@ vector<string> ParserEngine::dbTokens(string commandLine){ //Scanner-Tokenizer
 				closeSymbol=false;
 				openQuote=true;						//If the previous string was not a symbol and there was no previous openQuote, this quote
 		   }										//will be treated as an opening quote.
-		   else if(*position=="<"||*position=="="||*position=="-"||*position=="!")		//As with the previous conditional checks, this check
-			{																			//accounts for all possible openSymbols.
+		   else if(*position=="<"||*position=="="||*position=="-"||*position=="!"||*position=="^")	//As with the previous conditional checks, this check
+			{																							//accounts for all possible openSymbols.
 				openSymbol=true;
 				temp=temp+*position;
 			}
@@ -860,72 +1413,77 @@ vector<string> ParserEngine::dbTokens(string commandLine){ //Scanner-Tokenizer
    }
    return tokens;			//A vector full of the tokens ready for translation by the database engine.
 }
-Relation* ParserEngine::doExpr(int* qStart){
-/*bool isExp = isSelection();
-		
-	if(!isExp){
-		isExp=isProjection();
-	}
-	if(!isExp){
-		isExp=isRenaming();
-	}
-	if(!isExp){
-		isExp=isUnion();
-	}
-	if(!isExp){
-		sI=exprI;
-		isExp=isDifference();
-	}
-	if(!isExp){
-		sI=exprI;
-		isExp=isProduct();
-	}
-	if(!isExp){
-		sI=exprI;
-		isExp=isAtomicExpr();
-	}
-	if(!isExp){
-		sI=exprI;
-	}*/
-	
-
-
-	enter("doExpr");
+PlanPtr ParserEngine::getExpr(int* qStart){
+//expr ::= atomic-expr | selection | projection | renaming | ordering | limiting | grouping | union | difference | product | join
+	enter("getExpr");
 	int qS=(*qStart);
 	
-	Relation* expRel;
+	PlanPtr expPlan;
 	
-	//cout<<"qS:"<<qS<<endl;
-	if(sToks[qS] == "select"){
-		expRel = doSelect(&qS);
+	if(sIds[qS] == KW_SELECT){
+		expPlan = getSelection(&qS);
 	}
 	else if(isProjection1(qS)){
-		expRel = doProjection(&qS);
-	
+		expPlan = getProjection(&qS);
 	}
-	else if(sToks[qS] == "rename"){
-		expRel = doRename(&qS);
+	else if(sIds[qS] == KW_RENAME){
+		expPlan = getRenaming(&qS);
+	}
+	else if(sIds[qS] == KW_ORDER){
+		expPlan = getOrdering(&qS);
+	}
+	else if(sIds[qS] == KW_LIMIT){
+		expPlan = getLimiting(&qS);
+	}
+	else if(sIds[qS] == KW_GROUP){
+		expPlan = getGrouping(&qS);
+	}
+	else{
+		//atomic-expr, or the left side of a union, difference, product or join
+		expPlan = getAtomicExpr(&qS);
+		PlanType binaryType = ScanPlan;
+		if(sIds[qS] == KW_JOIN){
+			//join ::= atomic-expr join ( attribute-name == attribute-name ) atomic-expr
+			string leftAttr = sToks[qS+2];
+			string rightAttr = sToks[qS+4];
+			qS+=6;
+			PlanPtr rightPlan = getAtomicExpr(&qS);
+			expPlan = makeJoinPlan(expPlan, rightPlan, leftAttr, rightAttr);
+		}else if(sIds[qS] == SYM_PLUS){
+			binaryType = UnionPlan;
+		}else if(sIds[qS] == SYM_MINUS){
+			binaryType = DifferencePlan;
+		}else if(sIds[qS] == SYM_STAR){
+			binaryType = ProductPlan;
+		}
+		if(binaryType != ScanPlan){
+			qS++;
+			PlanPtr rightPlan = getAtomicExpr(&qS);
+			expPlan = makeBinaryPlan(binaryType, expPlan, rightPlan);
+		}
 	}
 
 	(*qStart) = qS;
-	leave("doExpr");
-	return expRel;	
+	leave("getExpr");
+	return expPlan;	
 }
 vector<string> ParserEngine::getAttributeList(int* attrListS){
 	enter("getATTRLIST");
 	vector<string> attrs;
 	int alS= (*attrListS);
 	
-	cout<<"\n\n\n\n";
-	printSTok();
-	cout<<"alS="<<alS<<"\n\n\n";
+	if(debug>1){
+		cout<<"\n\n\n\n";
+		printSTok();
+		cout<<"alS="<<alS<<"\n\n\n";
+	}
 	
 	
 	
-	while(sToks[alS]!=")"){
+	while(sIds[alS]!=SYM_RPAREN){
 		attrs.push_back(sToks[alS]);
 		alS++;
-		if(sToks[alS]==","){
+		if(sIds[alS]==SYM_COMMA){
 			alS++;
 		}
 	}
@@ -945,7 +1503,7 @@ Condition ParserEngine::getCondition(int* conS){
 	Condition cond;
 	Conjunction conj=getConjunction(&cS);
 	cond.conjunctions.push_back(conj);
-	while(sToks[cS]=="||"){
+	while(sIds[cS]==SYM_OR){
 		cS++;
 		conj = getConjunction(&cS);
 		cond.conjunctions.push_back(conj);
@@ -961,7 +1519,7 @@ Conjunction ParserEngine::getConjunction(int* conJ){
 	Conjunction conj;
 	Comparison comp = getComparison(&cS);
 	conj.comparisons.push_back(comp);
-	while(sToks[cS]=="&&"){
+	while(sIds[cS]==SYM_AND){
 		cS++;
 		comp = getComparison(&cS);
 		conj.comparisons.push_back(comp);
@@ -977,7 +1535,7 @@ Comparison ParserEngine::getComparison(int* comP){
 	Comparison comp;
 	
 	
-	if(sToks[cS]=="("){
+	if(sIds[cS]==SYM_LPAREN){
 		cS++;
 		comp.isCondition=true;
 		comp.cond=getCondition(&cS);
@@ -999,18 +1557,20 @@ Operation ParserEngine::getOp(int* opI){
 	enter("getOp");
 	int oI = (*opI);
 	Operation oper;
-	if(sToks[oI] == "=="){
+	if(sIds[oI] == SYM_EQ){
 		oper=Equality;
-	}else if(sToks[oI] == "!="){
+	}else if(sIds[oI] == SYM_NEQ){
 		oper=NonEquality;
-	}else if(sToks[oI] == "<"){
+	}else if(sIds[oI] == SYM_LT){
 		oper=LessThan;
-	}else if(sToks[oI] == ">"){
+	}else if(sIds[oI] == SYM_GT){
 		oper=GreaterThan;
-	}else if(sToks[oI] == "<="){
+	}else if(sIds[oI] == SYM_LTE){
 		oper=LessThanEqual;
-	}else if(sToks[oI] == ">="){
+	}else if(sIds[oI] == SYM_GTE){
 		oper=GreaterThanEqual;
+	}else if(sIds[oI] == SYM_PREFIX){
+		oper=Prefix;
 	}
 	oI++;
 	(*opI) = oI;
@@ -1024,7 +1584,7 @@ Operand ParserEngine::getOperand(int* opandI){
 	Operand opernd;
 	
 	string firstTok = sToks[opI];
-	if(firstTok=="\"" || firstTok=="-" || isdigit(firstTok[0])){
+	if(sIds[opI]==SYM_QUOTE || sIds[opI]==SYM_MINUS || isdigit(firstTok[0])){
 		opernd.isAttribute = false;
 		string lit = getLiteral(&opI);
 		opernd.val=lit;
@@ -1032,6 +1592,7 @@ Operand ParserEngine::getOperand(int* opandI){
 		opernd.isAttribute = true;
 		string aN = getAttributeName(&opI);
 		opernd.val=aN;
+		opernd.nameId=symbols().intern(aN);
 	}
 	(*opandI) = opI;
 	leave("getOperand");
@@ -1041,14 +1602,14 @@ string ParserEngine::getLiteral(int* litS){
 	enter("getLiteral");
 	int lS = (*litS);
 	string litt="";
-	if(sToks[lS]=="\""){
+	if(sIds[lS]==SYM_QUOTE){
 		lS++;
-		while(sToks[lS] != "\""){
+		while(sIds[lS] != SYM_QUOTE){
 			litt+=sToks[lS];
 			lS++;
 		}
 		lS++;
-	}else if(sToks[lS]=="-"){
+	}else if(sIds[lS]==SYM_MINUS){
 		litt+=sToks[lS];
 		lS++;
 		litt+=sToks[lS];
@@ -1076,6 +1637,15 @@ string ParserEngine::getRelationName(int* relS){
 	return rN;
 }
 
+bool ParserEngine::valuesFit(Relation* rel, vector<string>& tuple){
+	//INSERT/UPDATE may not store a value longer than its VARCHAR(n) column allows
+	int badI = rel->findOverlongValue(tuple);
+	if(badI!=-1){
+		cerr<<"****| ERROR |**| \""<<tuple[badI]<<"\" is too long for "<<rel->columns[badI].getName()<<" "<<rel->columns[badI].getType()<<" |****"<<endl;
+		return false;
+	}
+	return true;
+}
 Relation* ParserEngine::doUpdate(int* upStart){
 	//UPDATE dots SET x1 = 0 WHERE x1 < 0;
 	//update-cmd ::= UPDATE relation-name SET attribute-name = literal { , attribute-name = literal } WHERE condition
@@ -1090,13 +1660,24 @@ Relation* ParserEngine::doUpdate(int* upStart){
 		attribNames.push_back(getAttributeName(&upI));
 		upI++; //consume "=" token
 		lits.push_back(getLiteral(&upI));
-	}while(sToks[upI]==",");
+	}while(sIds[upI]==SYM_COMMA);
 	upI++; //consume "WHERE" token
 	Condition cond = getCondition(&upI);
 	
-	Relation* updateRel = ownerDBMS->relsInMem[relName];
+	Relation* updateRel = ownerDBMS->dbEngine->GetRelation(relName);
+	if(updateRel==0){
+		leave("doUpdate");
+		return 0;
+	}
+	for(int at = 0; at<attribNames.size(); at++){
+		if(updateRel->columnIndex(symbols().find(attribNames[at]))==-1 || !updateRel->findAttributeP(attribNames[at])->fits(lits[at])){
+			cerr<<"****| ERROR |**| Cannot set "<<attribNames[at]<<" to \""<<lits[at]<<"\" |****"<<endl;
+			leave("doUpdate");
+			return 0;
+		}
+	}
 	vector<int> updateTuples;
-	int cellCnt = updateRel->columns[0].cells.size();
+	int cellCnt = updateRel->columns[0].getSize();
 	for(int i=0; i<cellCnt; i++){
 		if(cond.passes(updateRel,i)){
 			updateTuples.push_back(i);
@@ -1106,8 +1687,8 @@ Relation* ParserEngine::doUpdate(int* upStart){
 	for(vector<int>::iterator it = updateTuples.begin(); it!=updateTuples.end(); ++it){
 		int tupleI = (*it);
 		for(int at = 0; at<attribNames.size(); at++){
-			cout<<"****"<<updateRel->findAttributeP(attribNames[at])->cells[tupleI]<<" : "<<lits[at]<<endl;
-			updateRel->findAttributeP(attribNames[at])->cells[tupleI] = lits[at];
+			if(debug>1){cout<<"****"<<updateRel->findAttributeP(attribNames[at])->getElement(tupleI)<<" : "<<lits[at]<<endl;}
+			updateRel->findAttributeP(attribNames[at])->setElement(tupleI, lits[at]);
 		}		
 	}
 	(*upStart)=upI;
@@ -1115,124 +1696,115 @@ Relation* ParserEngine::doUpdate(int* upStart){
 	return updateRel;
 	
 }
-Relation* ParserEngine::doProduct(){
-//product ::= atomic-expr * atomic-expr 
-	/*enter("isProduct");
-	bool isProd=false;
-	if(isAtomicExpr()){
-		if(sToks[sI]=="*"){
-			sI++;
-			if(isAtomicExpr()){
-				isProd=true;
-			}else{errOut("Expected <atomic-expr> to follow \"<atomic-expr> * \"");}
-		}
-	}		
-	leave("isProduct");
-	return isProd;*/
-	return false;
-}
-
-
-Relation* ParserEngine::doSelect(int* selStart){
+PlanPtr ParserEngine::getSelection(int* selStart){
 	//high_hitters <- select (homeruns >= 40) baseball_players;
 	//selection ::= select ( condition ) atomic-expr
-	enter("doSelect");
+	enter("getSelection");
 	int ss = (*selStart);
 	ss+=2;
 	Condition cond = getCondition(&ss);
 	ss++;
-	Relation* frmRel = doAtomicExpr(&ss);
-	Relation* newRel = new Relation("select");
-	for(int i=0; i<frmRel->columns.size(); i++){
-		newRel->addAttribute(frmRel->columns[i].name, frmRel->columns[i].type);
-	}
-	newRel->getHeight();
-	vector<int> passedTupInds();
-	for(int i=0; i<frmRel->columns[0].cells.size(); i++){
-			if(cond.passes(frmRel, i)){
-				newRel->addTuple(frmRel->getTuple(i));
-			}
-	}
-	
+	PlanPtr frmPlan = getAtomicExpr(&ss);
 	(*selStart) = ss;
-	ownerDBMS->scratchRels.push_back(newRel);
-	
-	
-	leave("doSelect");
-	return newRel;
-	
-	
-	
+	leave("getSelection");
+	return makeSelectPlan(cond, frmPlan);
 }
-Relation* ParserEngine::doAtomicExpr(int* aeStart){
-	//printSTok();
-	//cout<<"aeSTART+++++="<<(*aeStart)<<endl;
-	enter("doAE");
+PlanPtr ParserEngine::getAtomicExpr(int* aeStart){
+//atomic-expr ::= relation-name | ( expr )
+	enter("getAE");
 	int aeS = (*aeStart);
-	//TODO: IMPLEMENT REST!
-	string relName=sToks[aeS];	
-	leave("doAE");
-	return ownerDBMS->relsInMem[relName];
-	//if rel not in mem, open
-
+	PlanPtr aePlan;
+	if(sIds[aeS]==SYM_LPAREN){
+		aeS++; //consume "("
+		aePlan = getExpr(&aeS);
+		aeS++; //consume ")"
+	}else{
+		aePlan = makeScanPlan(getRelationName(&aeS));
+	}
+	(*aeStart) = aeS;
+	leave("getAE");
+	return aePlan;
 }
-Relation* ParserEngine::doProjection(int* qStart){
-
+PlanPtr ParserEngine::getProjection(int* qStart){
+	//projection ::= project ( attribute-list ) atomic-expr
 	int pS = (*qStart);
 	pS+=2;
 	vector<string> attrList= getAttributeList(&pS);
-	
 	pS++;
-	
-	Relation* fromRel = doAtomicExpr(&pS);
-	
-	Relation* newRel = new Relation("projectionRel");
-	
-	
-	for(int i=0; i<attrList.size(); i++){
-		string attrName = attrList[i];
-		Attribute newAttr = fromRel->findAttribute(attrName);
-		newRel->addAttribute(newAttr);
-	}
-	
-	ownerDBMS->scratchRels.push_back(newRel);
-	
-	return newRel;
-	
+	PlanPtr fromPlan = getAtomicExpr(&pS);
+	(*qStart) = pS;
+	return makeProjectPlan(attrList, fromPlan);
 }
-Relation* ParserEngine::doRename(int* qStart){
+PlanPtr ParserEngine::getRenaming(int* qStart){
+	//renaming ::= rename ( attribute-list ) atomic-expr
 	int rS = (*qStart);
 	rS+=2;
 	vector<string> attrList= getAttributeList(&rS);
 	rS++;
-	Relation* fromRel = doAtomicExpr(&rS);
-	
-	Relation* newRel = new Relation("renamingRel");
-	
-	for(int i=0; i<attrList.size(); i++){
-		string newAttrName = attrList[i];
-		Attribute newAttr = fromRel->columns[i];
-		newAttr.name=newAttrName;
-		newRel->addAttribute(newAttr);
+	PlanPtr fromPlan = getAtomicExpr(&rS);
+	(*qStart) = rS;
+	return makeRenamePlan(attrList, fromPlan);
+}
+PlanPtr ParserEngine::getOrdering(int* qStart){
+	//ordering ::= order ( attribute-list ) atomic-expr
+	int oS = (*qStart);
+	oS+=2;
+	vector<string> attrList= getAttributeList(&oS);
+	oS++;
+	PlanPtr fromPlan = getAtomicExpr(&oS);
+	(*qStart) = oS;
+	return makeOrderPlan(attrList, fromPlan);
+}
+PlanPtr ParserEngine::getLimiting(int* qStart){
+	//limiting ::= limit ( integer ) atomic-expr
+	int lS = (*qStart);
+	int count = Helpers::stringToInt(sToks[lS+2]);
+	lS+=4;
+	PlanPtr fromPlan = getAtomicExpr(&lS);
+	(*qStart) = lS;
+	return makeLimitPlan(count, fromPlan);
+}
+PlanPtr ParserEngine::getGrouping(int* qStart){
+	//grouping ::= group ( attribute-list ) aggregate ( aggregate-list ) atomic-expr
+	int gS = (*qStart);
+	gS+=2;
+	vector<string> attrList= getAttributeList(&gS);
+	gS+=3;
+	vector<AggregateCall> aggList = getAggregateList(&gS);
+	gS++;
+	PlanPtr fromPlan = getAtomicExpr(&gS);
+	(*qStart) = gS;
+	return makeGroupPlan(attrList, aggList, fromPlan);
+}
+vector<AggregateCall> ParserEngine::getAggregateList(int* aggListS){
+	//aggregate-list ::= aggregate { , aggregate }
+	int aS = (*aggListS);
+	vector<AggregateCall> aggList;
+	while(true){
+		AggregateFunction function = (AggregateFunction)(sIds[aS] - KW_COUNT); //KW_COUNT..KW_AVG are in AggregateFunction order
+		string attr = (sIds[aS+2] == SYM_STAR ? "" : sToks[aS+2]);
+		aggList.push_back(AggregateCall(function, attr));
+		aS+=4;
+		if(sIds[aS] != SYM_COMMA){
+			break;
+		}
+		aS++;
 	}
-	
-	ownerDBMS->scratchRels.push_back(newRel);
-	
-	return newRel;
-	
+	(*aggListS) = aS;
+	return aggList;
 }
 bool ParserEngine::isProjection1(int pS){
-	return sToks[pS] == "project";
+	return sIds[pS] == KW_PROJECT;
 }
 bool ParserEngine::isAtomicExpr(){
 //atomic-expr ::= relation-name | ( expr )
 	enter("isAtomicExpr");
 	bool isAE=false;
-	if(sToks[sI]=="("){
+	if(sIds[sI]==SYM_LPAREN){
 		//"atomic-expr ::= ( expr )" case
 		sI++;
 		if(isExpr()){
-			if(sToks[sI]==")"){
+			if(sIds[sI]==SYM_RPAREN){
 				sI++;
 				isAE=true;
 			}else{errOut("Expected closing-paren for expression in atomic-expression");}
@@ -1249,7 +1821,7 @@ bool ParserEngine::isQuery(){
 	enter("isQuery");
 	bool isQ=false;
 	if(isRelationName()){
-		if(sToks[sI]=="<-"){
+		if(sIds[sI]==SYM_ARROW){
 			sI++;
 			if(isExpr()){
 				isQ=true;
@@ -1258,7 +1830,7 @@ bool ParserEngine::isQuery(){
 	}
 	if( sI>=sToks.size() ){
 		isQ=false;
-	}else if(sToks[sI]!=";"){
+	}else if(sIds[sI]!=SYM_SEMICOLON){
 		isQ=false;
 	}
 	leave("isQuery");
@@ -1268,12 +1840,12 @@ bool ParserEngine::isSelection(){
 //selection ::= select ( condition ) atomic-expr
 	enter("isSelection");
 	bool isSel=false;
-	if(sToks[sI]=="select"){
+	if(sIds[sI]==KW_SELECT){
 		sI++;
-		if(sToks[sI]=="("){
+		if(sIds[sI]==SYM_LPAREN){
 			sI++;
 			if(isCondition()){
-				if(sToks[sI]==")"){
+				if(sIds[sI]==SYM_RPAREN){
 					sI++;
 					if(isAtomicExpr()){
 						isSel=true;
@@ -1289,12 +1861,12 @@ bool ParserEngine::isProjection(){
 // projection ::= project ( attribute-list ) atomic-expr
 	enter("Projection");
 	bool isProj=false;
-	if(sToks[sI]=="project"){
+	if(sIds[sI]==KW_PROJECT){
 		sI++;
-		if(sToks[sI]=="("){
+		if(sIds[sI]==SYM_LPAREN){
 			sI++;
 			if(isAttributeList()){
-				if(sToks[sI]==")"){
+				if(sIds[sI]==SYM_RPAREN){
 					sI++;
 					if(isAtomicExpr()){
 						isProj=true;
@@ -1311,12 +1883,12 @@ bool ParserEngine::isRenaming(){
 // rename_test <- rename (v_fname, v_lname, v_personality, v_bounty) enemies;
 	enter("isRenaming");
 	bool isRen=false;
-	if(sToks[sI]=="rename"){
+	if(sIds[sI]==KW_RENAME){
 		sI++;
-		if(sToks[sI]=="("){
+		if(sIds[sI]==SYM_LPAREN){
 			sI++;
 			if(isAttributeList()){
-				if(sToks[sI]==")"){
+				if(sIds[sI]==SYM_RPAREN){
 					sI++;
 					if(isAtomicExpr()){
 						isRen=true;
@@ -1328,12 +1900,128 @@ bool ParserEngine::isRenaming(){
 	leave("isRenaming");
 	return isRen;
 }
+bool ParserEngine::isOrdering(){
+// ordering ::= order ( attribute-list ) atomic-expr
+	enter("isOrdering");
+	bool isOrd=false;
+	if(sIds[sI]==KW_ORDER){
+		sI++;
+		if(sIds[sI]==SYM_LPAREN){
+			sI++;
+			if(isAttributeList()){
+				if(sIds[sI]==SYM_RPAREN){
+					sI++;
+					if(isAtomicExpr()){
+						isOrd=true;
+					}else{errOut("Expected <atomic-expresion> to follow \"order ( <attribute-list> ) \"");}
+				}else{errOut("Expected close-paren to follow \"order ( <attribute-list> \"");}
+			}else{errOut("Expected <attribute-list> to follow \"order ( \"");}
+		}else{errOut("Expected open-paren to follow \"order \"");}
+	}
+	leave("isOrdering");
+	return isOrd;
+}
+bool ParserEngine::isLimiting(){
+// limiting ::= limit ( integer ) atomic-expr
+	enter("isLimiting");
+	bool isLim=false;
+	if(sIds[sI]==KW_LIMIT){
+		sI++;
+		if(sIds[sI]==SYM_LPAREN){
+			sI++;
+			if(isInteger()){
+				sI++;
+				if(sIds[sI]==SYM_RPAREN){
+					sI++;
+					if(isAtomicExpr()){
+						isLim=true;
+					}else{errOut("Expected <atomic-expresion> to follow \"limit ( <integer> ) \"");}
+				}else{errOut("Expected close-paren to follow \"limit ( <integer> \"");}
+			}else{errOut("Expected <integer> to follow \"limit ( \"");}
+		}else{errOut("Expected open-paren to follow \"limit \"");}
+	}
+	leave("isLimiting");
+	return isLim;
+}
+bool ParserEngine::isGrouping(){
+// grouping ::= group ( attribute-list ) aggregate ( aggregate-list ) atomic-expr
+	enter("isGrouping");
+	bool isGrp=false;
+	if(sIds[sI]==KW_GROUP){
+		sI++;
+		if(sIds[sI]==SYM_LPAREN){
+			sI++;
+			if(isAttributeList()){
+				if(sIds[sI]==SYM_RPAREN && sIds[sI+1]==KW_AGGREGATE){
+					sI+=2;
+					if(sIds[sI]==SYM_LPAREN){
+						sI++;
+						if(isAggregateList()){
+							if(sIds[sI]==SYM_RPAREN){
+								sI++;
+								if(isAtomicExpr()){
+									isGrp=true;
+								}else{errOut("Expected <atomic-expresion> to follow \"group ( <attribute-list> ) aggregate ( <aggregate-list> ) \"");}
+							}else{errOut("Expected close-paren to follow \"group ( <attribute-list> ) aggregate ( <aggregate-list> \"");}
+						}else{errOut("Expected <aggregate-list> to follow \"group ( <attribute-list> ) aggregate ( \"");}
+					}else{errOut("Expected open-paren to follow \"group ( <attribute-list> ) aggregate \"");}
+				}else{errOut("Expected \") aggregate\" to follow \"group ( <attribute-list> \"");}
+			}else{errOut("Expected <attribute-list> to follow \"group ( \"");}
+		}else{errOut("Expected open-paren to follow \"group \"");}
+	}
+	leave("isGrouping");
+	return isGrp;
+}
+bool ParserEngine::isAggregateList(){
+//aggregate-list ::= aggregate { , aggregate }
+	enter("isAggregateList");
+	bool isAL = false;
+	if(isAggregate()){
+		isAL = true;
+		while(sIds[sI]==SYM_COMMA){
+			sI++;
+			if(!isAggregate()){
+				isAL=false;
+				errOut("Error within aggregate-list, expected aggregate after comma");
+				break;
+			}
+		}
+	}else{errOut("Expected at least 1 aggregate in aggregate-list");}
+	leave("isAggregateList");
+	return isAL;
+}
+bool ParserEngine::isAggregate(){
+//aggregate ::= count ( * ) | ( count | sum | min | max | avg ) ( attribute-name )
+	enter("isAggregate");
+	bool isAgg = false;
+	int function = sIds[sI];
+	if(function>=KW_COUNT && function<=KW_AVG){
+		sI++;
+		if(sIds[sI]==SYM_LPAREN){
+			sI++;
+			if(function==KW_COUNT && sIds[sI]==SYM_STAR){
+				sI++;
+				isAgg = true;
+			}else{
+				isAgg = isAttributeName();
+			}
+			if(isAgg && sIds[sI]==SYM_RPAREN){
+				sI++;
+			}else{
+				isAgg = false;
+				errOut("Expected \"( <attribute-name> )\" to follow \""+symbols().name(function)+"\"");
+			}
+		}else{errOut("Expected open-paren to follow \""+symbols().name(function)+"\"");}
+	}
+	leave("isAggregate");
+	return isAgg;
+}
 bool ParserEngine::isUnion(){
 // union ::= atomic-expr + atomic-expr
 	enter("isUnion");
 	bool isUn=false;
 	if(isAtomicExpr()){
-		if(sToks[sI]=="+"){
+		if(sIds[sI]==SYM_PLUS){
 			sI++;
 			if(isAtomicExpr()){
 				isUn=true;
@@ -1348,7 +2036,7 @@ bool ParserEngine::isProduct(){
 	enter("isProduct");
 	bool isProd=false;
 	if(isAtomicExpr()){
-		if(sToks[sI]=="*"){
+		if(sIds[sI]==SYM_STAR){
 			sI++;
 			if(isAtomicExpr()){
 				isProd=true;
@@ -1358,12 +2046,36 @@ bool ParserEngine::isProduct(){
 	leave("isProduct");
 	return isProd;
 }
+bool ParserEngine::isJoin(){
+//join ::= atomic-expr join ( attribute-name == attribute-name ) atomic-expr
+	enter("isJoin");
+	bool isJn=false;
+	if(isAtomicExpr()){
+		if(sIds[sI]==KW_JOIN){
+			sI++;
+			if(sIds[sI]==SYM_LPAREN){
+				sI++;
+				if(isAttributeName() && sIds[sI]==SYM_EQ){
+					sI++;
+					if(isAttributeName() && sIds[sI]==SYM_RPAREN){
+						sI++;
+						if(isAtomicExpr()){
+							isJn=true;
+						}else{errOut("Expected <atomic-expr> to follow \"<atomic-expr> join ( <attribute-name> == <attribute-name> ) \"");}
+					}else{errOut("Expected <attribute-name> and close-paren to follow \"<atomic-expr> join ( <attribute-name> == \"");}
+				}else{errOut("Expected \"<attribute-name> ==\" to follow \"<atomic-expr> join ( \"");}
+			}else{errOut("Expected open-paren to follow \"<atomic-expr> join\"");}
+		}
+	}
+	leave("isJoin");
+	return isJn;
+}
 bool ParserEngine::isDifference(){
 // difference ::= atomic-expr - atomic-expr
 	enter("isDifference");
 	bool isDif=false;
 	if(isAtomicExpr()){
-		if(sToks[sI]=="-"){
+		if(sIds[sI]==SYM_MINUS){
 			sI++;
 			if(isAtomicExpr()){
 				isDif=true;
@@ -1374,7 +2086,7 @@ bool ParserEngine::isDifference(){
 	return isDif;
 }
 bool ParserEngine::isExpr() {
-//expr ::= atomic-expr | selection | projection | renaming | union | difference | product
+//expr ::= atomic-expr | selection | projection | renaming | ordering | limiting | grouping | union | difference | product | join
 	enter("isExpr");
 	int exprI = sI;
 	bool isExp = isSelection();
@@ -1385,6 +2097,15 @@ bool ParserEngine::isExpr() {
 	if(!isExp){
 		isExp=isRenaming();
 	}
+	if(!isExp){
+		isExp=isOrdering();
+	}
+	if(!isExp){
+		isExp=isLimiting();
+	}
+	if(!isExp){
+		isExp=isGrouping();
+	}
 	if(!isExp){
 		isExp=isUnion();
 	}
@@ -1396,6 +2117,10 @@ bool ParserEngine::isExpr() {
 		sI=exprI;
 		isExp=isProduct();
 	}
+	if(!isExp){
+		sI=exprI;
+		isExp=isJoin();
+	}
 	if(!isExp){
 		sI=exprI;
 		isExp=isAtomicExpr();
@@ -1441,7 +2166,7 @@ bool ParserEngine::isAttributeList(){
 	if(isAttributeName()){
 		isAL =true;
 		int atNameSI = sI; //TODO: NOTE: this will be the first attribute name
-		while(sToks[sI]==","){
+		while(sIds[sI]==SYM_COMMA){
 			sI++;
 			if(isAttributeName()){
 				int atNamesSI = sI; //TODO: NOTE: these will be indexes to any following attribute names
@@ -1466,18 +2191,18 @@ bool ParserEngine::isType(){
 	bool isType = false;
 	int tSi = sI;
 	
-	if(sToks[sI]=="INTEGER"){
+	if(sIds[sI]==KW_INTEGER){
 		isType=true;
 		sI++;
 	}
-	else if(sToks[sI]=="VARCHAR"){
+	else if(sIds[sI]==KW_VARCHAR){
 		sI++;
-		if(sToks[sI]=="("){
+		if(sIds[sI]==SYM_LPAREN){
 			sI++;
 			if(isInteger()){
 				int VarCountIndex=sI; //TODO: NOTE: this will be the index of the token representing the varchar count
 				sI++;
-				if(sToks[sI]==")"){
+				if(sIds[sI]==SYM_RPAREN){
 					sI++;
 					isType=true;
 				}else{errOut("Expected closing-paren following VARCHAR");}
@@ -1510,16 +2235,16 @@ bool ParserEngine::isLiteral(){
 	int literalStartIndex = sI; 
 	int literalEndIndex = sI;
 	bool isLit=false;
-	if(sToks[sI]=="\""){ //Quoted literal
+	if(sIds[sI]==SYM_QUOTE){ //Quoted literal
 		sI++; //consume open "
 		literalStartIndex = sI;
-		while(sToks[sI]!="\""){
+		while(sIds[sI]!=SYM_QUOTE){
 			sI++; //consume literal bit
 		}
 		literalEndIndex = sI-1;
 		sI++; // consume end "
 		isLit=true;
-	}else if(sToks[sI]=="-"){
+	}else if(sIds[sI]==SYM_MINUS){
 		literalStartIndex = sI;
 		sI++;
 		literalEndIndex = sI;
@@ -1540,7 +2265,7 @@ bool ParserEngine::isTypedAttributeList(){
 	if(isAttributeName()){
 		if(isType()){
 			isTA=true;
-			while(sToks[sI]==","){
+			while(sIds[sI]==SYM_COMMA){
 				sI++;
 				if(isAttributeName()){
 					if(isType()){
@@ -1563,7 +2288,7 @@ bool ParserEngine::isCondition(){
 	bool isCond = false;
 	if(isConjunction()){
 		isCond=true;
-		while(sToks[sI]=="||"){
+		while(sIds[sI]==SYM_OR){
 			sI++;
 			if(isConjunction()){
 				isCond = true;
@@ -1579,7 +2304,7 @@ bool ParserEngine::isConjunction(){
 	bool isConj = false;
 	if(isComparison()){
 		isConj=true;
-		while(sToks[sI]=="&&"){
+		while(sIds[sI]==SYM_AND){
 			sI++;
 			if(isComparison()){
 				isConj=true;
@@ -1594,10 +2319,10 @@ bool ParserEngine::isComparison(){
 	enter("isComparison");
 	bool isComp = false;
 	
-	if(sToks[sI]=="("){
+	if(sIds[sI]==SYM_LPAREN){
 		sI++;
 		if(isCondition()){
-			if(sToks[sI]==")"){
+			if(sIds[sI]==SYM_RPAREN){
 				sI++;
 				isComp=true;
 			}else{errOut("Expected closing paren on condition within comparison");}
@@ -1616,20 +2341,22 @@ bool ParserEngine::isComparison(){
 	return isComp;
 }
 bool ParserEngine::isOp(){
-//enum opEnum {"=="=0, "!=", "<" , ">", "<=", ">="}
+//enum opEnum {"=="=0, "!=", "<" , ">", "<=", ">=", "^="}
 	enter("isOp");
 	bool isop = true;
-	if(sToks[sI] == "=="){
+	if(sIds[sI] == SYM_EQ){
 		
-	}else if(sToks[sI] == "!="){
+	}else if(sIds[sI] == SYM_NEQ){
+	
+	}else if(sIds[sI] == SYM_LT){
 	
-	}else if(sToks[sI] == "<"){
+	}else if(sIds[sI] == SYM_GT){
 	
-	}else if(sToks[sI] == ">"){
+	}else if(sIds[sI] == SYM_LTE){
 	
-	}else if(sToks[sI] == "<="){
+	}else if(sIds[sI] == SYM_GTE){
 	
-	}else if(sToks[sI] == ">="){
+	}else if(sIds[sI] == SYM_PREFIX){
 	
 	}else{
 		isop=false;
@@ -1656,16 +2383,16 @@ bool ParserEngine::isOperand(){
 }
 bool ParserEngine::isFCommand(){ 
 //Determines if first token matches a Command
-	string f = (allowNonCaps?Helpers::retUpper(sToks[sI]):sToks[sI]);
-	return ( (f=="OPEN") || (f=="CLOSE") || (f=="WRITE") || (f=="EXIT") || (f=="SHOW") || (f=="CREATE") || (f=="UPDATE") || (f=="INSERT") || (f=="DELETE") );
+	int f = upperSymbol(sI);
+	return ( (f==KW_OPEN) || (f==KW_CLOSE) || (f==KW_WRITE) || (f==KW_EXIT) || (f==KW_SHOW) || (f==KW_SET) || (f==KW_CREATE) || (f==KW_UPDATE) || (f==KW_INSERT) || (f==KW_DELETE) );
 }
 bool ParserEngine::isCommand(){
-//command ::= ( open-cmd | close-cmd | write-cmd | exit-cmd | show-cmd | create-cmd | update-cmd | insert-cmd | delete-cmd ) ;
+//command ::= ( open-cmd | close-cmd | write-cmd | exit-cmd | show-cmd | set-cmd | create-cmd | update-cmd | insert-cmd | delete-cmd ) ;
 	enter("isCommand");
 	bool isCmd = false;
 	if(isFCommand()){
-		if(isOpen() || isClose() || isWrite() || isExit() || isShow() || isCreate() || isUpdate() || isInsert() || isDelete()){
-			if(sToks[sI]==";"){
+		if(isOpen() || isClose() || isWrite() || isExit() || isShow() || isSet() || isCreate() || isUpdate() || isInsert() || isDelete()){
+			if(sIds[sI]==SYM_SEMICOLON){
 				isCmd=true;
 			}else{errOut("Expected ; after command!");}
 		}
@@ -1677,8 +2404,8 @@ bool ParserEngine::isOpen(){
 //open-cmd ::== OPEN relation-name
 	enter("isOpen");
 	bool isOpn=false;
-	sToks[sI] = (allowNonCaps?Helpers::retUpper(sToks[sI]):sToks[sI]);
-	if(sToks[sI]=="OPEN"){
+	foldCase(sI);
+	if(sIds[sI]==KW_OPEN){
 		sI++;
 		if(isRelationName()){
 			string relName=sToks[sI-1];
@@ -1692,8 +2419,8 @@ bool ParserEngine::isClose(){
 //close-cmd ::== CLOSE relation-name
 	enter("isClose");
 	bool isCls=false;
-	sToks[sI] = (allowNonCaps?Helpers::retUpper(sToks[sI]):sToks[sI]);
-	if(sToks[sI]=="CLOSE"){
+	foldCase(sI);
+	if(sIds[sI]==KW_CLOSE){
 		sI++;
 		if(isRelationName()){
 			string relName=sToks[sI-1];
@@ -1708,8 +2435,8 @@ bool ParserEngine::isWrite(){
 //write-cmd ::== WRITE relation-name
 	enter("isWrite");
 	bool isWrt=false;
-	sToks[sI] = (allowNonCaps?Helpers::retUpper(sToks[sI]):sToks[sI]);	
-	if(sToks[sI]=="WRITE"){
+	foldCase(sI);	
+	if(sIds[sI]==KW_WRITE){
 		sI++;
 		if(isRelationName()){
 			string relName=sToks[sI-1];
@@ -1725,8 +2452,8 @@ bool ParserEngine::isExit(){
 //exit-cmd ::== EXIT
 	enter("isExit");
 	bool isExt=false;
-	sToks[sI] = (allowNonCaps?Helpers::retUpper(sToks[sI]):sToks[sI]);
-	if(sToks[sI]=="EXIT"){
+	foldCase(sI);
+	if(sIds[sI]==KW_EXIT){
 		sI++;
 		isExt=true;
 	}
@@ -1737,8 +2464,8 @@ bool ParserEngine::isShow(){
 //show-cmd ::== SHOW atomic-expr
 	enter("isShow");
 	bool isShw=false;
-	sToks[sI] = (allowNonCaps?Helpers::retUpper(sToks[sI]):sToks[sI]);
-	if(sToks[sI]=="SHOW"){
+	foldCase(sI);
+	if(sIds[sI]==KW_SHOW){
 		sI++;
 		int atomicExprSI=sI;
 		if(isAtomicExpr()){
@@ -1750,36 +2477,83 @@ bool ParserEngine::isShow(){
 	leave("isShow");
 	return isShw;
 }
+bool ParserEngine::isSet(){
+//set-cmd ::== SET CRACKING ( ON | OFF ) | SET THREADS integer | SET SORT MEMORY integer
+	enter("isSet");
+	bool isSt=false;
+	foldCase(sI);
+	if(sIds[sI]==KW_SET){
+		sI++;
+		foldCase(sI);
+		if(sIds[sI]==KW_THREADS){
+			sI++;
+			if(isInteger()){
+				sI++;
+				isSt=true;
+			}else{ errOut("Expected an integer after \"SET THREADS\""); }
+		}else if(sIds[sI]==KW_SORT){
+			sI++;
+			foldCase(sI);
+			if(sIds[sI]==KW_MEMORY){
+				sI++;
+				if(isInteger()){
+					sI++;
+					isSt=true;
+				}else{ errOut("Expected an integer (kilobytes) after \"SET SORT MEMORY\""); }
+			}else{ errOut("Expected \"MEMORY\" after \"SET SORT\""); }
+		}else if(sIds[sI]==KW_CRACKING){
+			sI++;
+			foldCase(sI);
+			if(sIds[sI]==KW_ON || sIds[sI]==KW_OFF){
+				sI++;
+				isSt=true;
+			}else{ errOut("Expected \"ON\" or \"OFF\" after \"SET CRACKING\""); }
+		}else{ errOut("Expected \"CRACKING\", \"THREADS\" or \"SORT\" after \"SET\""); }
+	}
+	leave("isSet");
+	return isSt;
+}
 bool ParserEngine::isCreate(){
 //create-cmd ::= CREATE TABLE relation-name ( typed-attribute-list ) PRIMARY KEY ( attribute-list )
+//	| CREATE [ BITMAP ] INDEX identifier ON relation-name ( attribute-name )
 	enter("isCreate");
 	bool isCrt=false;
-	sToks[sI] = (allowNonCaps?Helpers::retUpper(sToks[sI]):sToks[sI]);
-	if(sToks[sI]=="CREATE"){
+	foldCase(sI);
+	if(sIds[sI]==KW_CREATE){
 		sI++;
-		sToks[sI] = (allowNonCaps?Helpers::retUpper(sToks[sI]):sToks[sI]);
-		if(sToks[sI] == "TABLE"){
+		foldCase(sI);
+		if(sIds[sI] == KW_BITMAP){
+			sI++;
+			foldCase(sI);
+			if(sIds[sI] == KW_INDEX){
+				sI++;
+				isCrt = isCreateIndex();
+			}else{errOut("Expected \"INDEX\" to follow \"CREATE BITMAP\"");}
+		}else if(sIds[sI] == KW_INDEX){
+			sI++;
+			isCrt = isCreateIndex();
+		}else if(sIds[sI] == KW_TABLE){
 			sI++;
 			if(isRelationName()){
 				string relName=sToks[sI-1];
-				if(sToks[sI] == "(" ){
+				if(sIds[sI] == SYM_LPAREN ){
 					sI++;
 					int typedAttrLstSI=sI;
 					if(isTypedAttributeList()){
 						int typedAttrLstEI=sI-1;
 						//vector<TypedAttribute> typedAttrs = TypedAttributeList();
-						if(sToks[sI]==")"){
+						if(sIds[sI]==SYM_RPAREN){
 							sI++;
-							string tempP = (allowNonCaps?Helpers::retUpper(sToks[sI]):sToks[sI]); //TODO: IDEA: should we combine 'primary' and 'key' as they should never be apart?
-							if(tempP=="PRIMARY"){
+							int tempP = upperSymbol(sI); //TODO: IDEA: should we combine 'primary' and 'key' as they should never be apart?
+							if(tempP==KW_PRIMARY){
 								sI++;
-								string tempK = (allowNonCaps?Helpers::retUpper(sToks[sI]):sToks[sI]);
-								if(tempK=="KEY"){
+								int tempK = upperSymbol(sI);
+								if(tempK==KW_KEY){
 									sI++;
-									if(sToks[sI]=="("){
+									if(sIds[sI]==SYM_LPAREN){
 										sI++;
 										if(isAttributeList()){
-											if(sToks[sI]==")"){
+											if(sIds[sI]==SYM_RPAREN){
 												sI++;
 												isCrt=true;
 											}else{errOut(" Expected closing-paren after \"CREATE TABLE "+relName+" ( <typed-attribute-list> ) PRIMARY KEY (<attribute-list>\"");}							
@@ -1796,27 +2570,52 @@ bool ParserEngine::isCreate(){
 	leave("isCreate");
 	return isCrt;
 }
+bool ParserEngine::isCreateIndex(){
+//the rest of CREATE [ BITMAP ] INDEX identifier ON relation-name ( attribute-name ), after "INDEX"
+	enter("isCreateIndex");
+	bool isCrt=false;
+	if(isIdentifier()){
+		string indexName=sToks[sI-1];
+		foldCase(sI);
+		if(sIds[sI]==KW_ON){
+			sI++;
+			if(isRelationName()){
+				if(sIds[sI]==SYM_LPAREN){
+					sI++;
+					if(isAttributeName()){
+						if(sIds[sI]==SYM_RPAREN){
+							sI++;
+							isCrt=true;
+						}else{errOut("Expected closing-paren after \"CREATE INDEX "+indexName+" ON <relation-name> ( <attribute-name>\"");}
+					}else{errOut("Expected 'attribute-name' after \"CREATE INDEX "+indexName+" ON <relation-name> (\"");}
+				}else{errOut("Expected open-paren after \"CREATE INDEX "+indexName+" ON <relation-name>\"");}
+			}else{errOut("Expected 'relation-name' after \"CREATE INDEX "+indexName+" ON\"");}
+		}else{errOut("Expected \"ON\" after \"CREATE INDEX "+indexName+"\"");}
+	}else{errOut("Expected index name after \"CREATE INDEX\"");}
+	leave("isCreateIndex");
+	return isCrt;
+}
 bool ParserEngine::isUpdate(){
 //UPDATE dots SET x1 = 0 WHERE x1 < 0;
 //update-cmd ::= UPDATE relation-name SET attribute-name = literal { , attribute-name = literal } WHERE condition
 	enter("isUpdate");
 	bool isUpd=false;
-	sToks[sI] = (allowNonCaps?Helpers::retUpper(sToks[sI]):sToks[sI]);
-	if(sToks[sI]=="UPDATE"){
+	foldCase(sI);
+	if(sIds[sI]==KW_UPDATE){
 		sI++;
 		if(isRelationName()){
 			string relName=sToks[sI-1];
-			if(sToks[sI]=="SET"){
+			if(sIds[sI]==KW_SET){
 				sI++;
 				//loop look here
 				if(isAttributeName()){
 					string attrName=sToks[sI-1];
-					if(sToks[sI]== "="){
+					if(sIds[sI]== SYM_ASSIGN){
 						sI++;
 						if(isLiteral()){
 							//TODO: FIX: some looping needed 
-							while(sToks[sI]==","){ cout<<"\n\n\nERROR, NO SUPPORT FOR MULTIPLE ATTRIBUTE-NAME ASSIGNMENTS YET\n\n\n"; return false; sI++;}
-							if(sToks[sI]=="WHERE"){
+							while(sIds[sI]==SYM_COMMA){ cout<<"\n\n\nERROR, NO SUPPORT FOR MULTIPLE ATTRIBUTE-NAME ASSIGNMENTS YET\n\n\n"; return false; sI++;}
+							if(sIds[sI]==KW_WHERE){
 								sI++;
 								if(isCondition()){
 									isUpd=true;
@@ -1836,39 +2635,39 @@ bool ParserEngine::isInsert(){
 			//  | INSERT INTO relation-name VALUES FROM RELATION expr
 	enter("isInsert");
 	bool isIns=false;
-	sToks[sI] = (allowNonCaps?Helpers::retUpper(sToks[sI]):sToks[sI]);
-	if(sToks[sI]=="INSERT"){
+	foldCase(sI);
+	if(sIds[sI]==KW_INSERT){
 		sI++;
-		sToks[sI] = (allowNonCaps?Helpers::retUpper(sToks[sI]):sToks[sI]); //mixed-case consideration for 'INTO'
-		if(sToks[sI]=="INTO"){
+		foldCase(sI); //mixed-case consideration for 'INTO'
+		if(sIds[sI]==KW_INTO){
 			sI++;
 			if(isRelationName()){
-				sToks[sI] = (allowNonCaps?Helpers::retUpper(sToks[sI]):sToks[sI]); //mixed-case consideration for 'VALUES'
-				if(sToks[sI]=="VALUES"){
+				foldCase(sI); //mixed-case consideration for 'VALUES'
+				if(sIds[sI]==KW_VALUES){
 					sI++;
-					sToks[sI] = (allowNonCaps?Helpers::retUpper(sToks[sI]):sToks[sI]); //mixed-case consideration for 'FROM'
-					if(sToks[sI] =="FROM"){
+					foldCase(sI); //mixed-case consideration for 'FROM'
+					if(sIds[sI] ==KW_FROM){
 						sI++;
-						string temp= (allowNonCaps?Helpers::retUpper(sToks[sI]):sToks[sI]); //mixed-case consideration for !!possible!! 'RELATION' token
-						if(temp=="RELATION"){
+						int temp= upperSymbol(sI); //mixed-case consideration for !!possible!! 'RELATION' token
+						if(temp==KW_RELATION){
 							//This is < VALUES FROM RELATION expr > case of 'INSERT'
-							sToks[sI] = (allowNonCaps?Helpers::retUpper(sToks[sI]):sToks[sI]); //mixed-case consideration for 'RELATION' token
+							foldCase(sI); //mixed-case consideration for 'RELATION' token
 							sI++; //consume 'RELATION'
 							if(isExpr()){
 								isIns=true;
 							}else{errOut("Expected expression to follow \"INSERT INTO relation-name VALUES FROM RELATION\"");}
-						}else if(sToks[sI]=="("){
+						}else if(sIds[sI]==SYM_LPAREN){
 							//This is the < VALUES FROM (literal{,literal}) > case of 'INSERT'
 							sI++;
 							if(isLiteral()){
-								while(sToks[sI]==","){
+								while(sIds[sI]==SYM_COMMA){
 									sI++;
 									if(isLiteral()){
 										; //TODO: POSSIBILITY: can handle individuals literals here.
 									}else{isIns=false; errOut("Expected Literal to follow ',' in \"INSERT INTO relation-name VALUES FROM ( literal { , literal } )\"");}
 								}
 							}
-							if(sToks[sI]==")"){
+							if(sIds[sI]==SYM_RPAREN){
 									sI++;
 									isIns=true;
 							}else{errOut("Expected ')' to follow 'INSERT INTO relation-name VALUES FROM ( literal { , literal } '");}
@@ -1885,15 +2684,15 @@ bool ParserEngine::isDelete(){
 //delete-cmd ::= DELETE FROM relation-name WHERE condition
 	enter("isDelete");
 	bool isDel=false;
-	sToks[sI] = (allowNonCaps?Helpers::retUpper(sToks[sI]):sToks[sI]);
-	if(sToks[sI]=="DELETE"){
+	foldCase(sI);
+	if(sIds[sI]==KW_DELETE){
 		sI++;
-		sToks[sI] = (allowNonCaps?Helpers::retUpper(sToks[sI]):sToks[sI]); //mixed-case consideration for 'FROM'
-		if(sToks[sI]=="FROM"){
+		foldCase(sI); //mixed-case consideration for 'FROM'
+		if(sIds[sI]==KW_FROM){
 			sI++;
 			if(isRelationName()){
-				sToks[sI] = (allowNonCaps?Helpers::retUpper(sToks[sI]):sToks[sI]); //mixed-case consideration for 'WHERE'
-				if(sToks[sI]=="WHERE"){
+				foldCase(sI); //mixed-case consideration for 'WHERE'
+				if(sIds[sI]==KW_WHERE){
 					sI++;
 					if(isCondition()){
 						isDel=true;
@@ -1937,3 +2736,344 @@ void ParserEngine::spaces(int local_level) {
 
 
 
+
+
+ExecEngine::ExecEngine(DBMS* OwnerDBMS, int Debug=1):debug(Debug){
+	ownerDBMS = OwnerDBMS;
+	cracking = false;
+	sortMemory = SORT_MEMORY_DEFAULT;
+}
+Relation* ExecEngine::Execute(PlanNode* plan, string resultName){
+	//returns 0 if the plan could not be run
+	QueryArena arena;
+	requireColumns(plan, true, set<string>());
+	Operator* root = buildOperator(plan, &arena);
+	if(root==0){
+		return 0;
+	}
+	Relation* result = materialize(root, resultName);
+	delete root;
+	finishQuery(&arena);
+	return result;
+}
+Cursor ExecEngine::Open(PlanNode* plan){
+	//streams the plan's result, an unknown relation gives an empty cursor
+	boost::shared_ptr<QueryArena> arena(new QueryArena());
+	requireColumns(plan, true, set<string>());
+	return Cursor(buildOperator(plan, arena.get()), arena, this);
+}
+void ExecEngine::finishQuery(QueryArena* arena){
+	//frees the query's intermediates
+	lastStats = arena->stats;
+	if(debug>=2){
+		lastStats.print();
+	}
+	arena->release();
+}
+Operator* ExecEngine::buildOperator(PlanNode* plan, QueryArena* arena){
+	//returns 0 if any relation in the plan could not be found
+	if(plan->type==LimitPlan && plan->children[0]->type==OrderPlan){
+		//the first tuples of an ordering: a heap of them instead of sorting everything
+		PlanNode* orderPlan = plan->children[0].get();
+		Operator* input = buildOperator(orderPlan->children[0].get(), arena);
+		if(input==0){
+			return 0;
+		}
+		Operator* op = new TopNOp(input, orderPlan->attrs, plan->count);
+		op->arena = arena;
+		return op;
+	}
+	vector<Operator*> inputs;
+	for(int i=0; i<plan->children.size(); i++){
+		Operator* input = buildOperator(plan->children[i].get(), arena);
+		if(input==0){
+			for(int j=0; j<inputs.size(); j++){
+				delete inputs[j];
+			}
+			return 0;
+		}
+		inputs.push_back(input);
+	}
+	Operator* op = 0;
+	switch(plan->type){
+		case ScanPlan:
+			op = doScan(plan);
+			break;
+		case SelectPlan:
+			op = new SelectOp(inputs[0], plan->cond, ownerDBMS->pool);
+			break;
+		case ProjectPlan:
+			op = new ProjectOp(inputs[0], plan->attrs);
+			break;
+		case RenamePlan:
+			op = new RenameOp(inputs[0], plan->attrs);
+			break;
+		case ProductPlan:
+			op = new ProductOp(inputs[0], inputs[1]);
+			break;
+		case JoinPlan:
+			op = doJoin(plan, inputs[0], inputs[1]);
+			break;
+		case LimitPlan:
+			op = new LimitOp(inputs[0], plan->count);
+			break;
+		case GroupPlan:
+			op = new HashAggregateOp(inputs[0], plan->attrs, plan->aggs, ownerDBMS->pool);
+			break;
+		case OrderPlan:
+			op = new OrderOp(inputs[0], plan->attrs, ownerDBMS->pool, sortMemory, ownerDBMS->dbEngine->dbFilePath);
+			break;
+		case UnionPlan:
+			op = new UnionOp(inputs[0], inputs[1]);
+			break;
+		case DifferencePlan:
+			op = new DifferenceOp(inputs[0], inputs[1]);
+			break;
+	}
+	if(op!=0){
+		op->arena = arena;
+	}
+	return op;
+}
+Operator* ExecEngine::doScan(PlanNode* plan){
+	//if rel not in mem, open (only the columns the query reads)
+	Relation* rel = ownerDBMS->dbEngine->GetRelation(plan->relId, plan->scanAll, plan->scanCols);
+	if(rel==0){
+		if(debug>0){cerr<<"****| ERROR |**| Relation "<<plan->relName<<" does not exist |****"<<endl;}
+		return 0;
+	}
+	return new ScanOp(rel, cracking);
+}
+Operator* ExecEngine::doJoin(PlanNode* plan, Operator* left, Operator* right){
+	//merge join if both inputs come out in order of their join attribute, or can by being read
+	//through a B+tree index, so no hash table over the whole right input is needed
+	string leftAttr = plan->attrs[0];
+	string rightAttr = plan->attrs[1];
+	int leftCol = left->findColumn(leftAttr);
+	int rightCol = right->findColumn(rightAttr);
+	if(leftCol!=-1 && rightCol!=-1 && left->types[leftCol].isInt()==right->types[rightCol].isInt()){
+		vector<string> leftOrder = left->sortedBy();
+		vector<string> rightOrder = right->sortedBy();
+		bool leftSorted = (!leftOrder.empty() && leftOrder[0]==leftAttr);
+		bool rightSorted = (!rightOrder.empty() && rightOrder[0]==rightAttr);
+		if((leftSorted || left->indexOrder(leftAttr, false)) && (rightSorted || right->indexOrder(rightAttr, false))){
+			if(!leftSorted){
+				left->indexOrder(leftAttr, true);
+			}
+			if(!rightSorted){
+				right->indexOrder(rightAttr, true);
+			}
+			return new MergeJoinOp(left, right, leftAttr, rightAttr);
+		}
+	}
+	return new HashJoinOp(left, right, leftAttr, rightAttr, ownerDBMS->pool);
+}
+void ExecEngine::requireColumns(PlanNode* plan, bool allCols, set<string> cols){
+	//works out, top down, which columns each scan has to load for the query to run
+	switch(plan->type){
+		case ScanPlan:
+			plan->scanAll = allCols;
+			plan->scanCols = cols;
+			return;
+		case SelectPlan:
+			plan->cond.attributes(cols);
+			requireColumns(plan->children[0].get(), allCols, cols);
+			return;
+		case ProjectPlan:
+			requireColumns(plan->children[0].get(), false, set<string>(plan->attrs.begin(), plan->attrs.end()));
+			return;
+		case OrderPlan:
+			cols.insert(plan->attrs.begin(), plan->attrs.end());
+			requireColumns(plan->children[0].get(), allCols, cols);
+			return;
+		case LimitPlan:
+			requireColumns(plan->children[0].get(), allCols, cols);
+			return;
+		case GroupPlan:
+			cols = set<string>(plan->attrs.begin(), plan->attrs.end());
+			for(int i=0; i<plan->aggs.size(); i++){
+				if(plan->aggs[i].attr!=""){
+					cols.insert(plan->aggs[i].attr);
+				}
+			}
+			requireColumns(plan->children[0].get(), false, cols);
+			return;
+		case ProductPlan:
+			requireColumns(plan->children[0].get(), allCols, cols);
+			requireColumns(plan->children[1].get(), allCols, cols);
+			return;
+		case JoinPlan:
+			for(int i=0; i<2; i++){
+				set<string> sideCols = cols;
+				sideCols.insert(plan->attrs[i]);
+				requireColumns(plan->children[i].get(), allCols, sideCols);
+			}
+			return;
+		default:
+			//rename is positional, union and difference compare whole tuples
+			for(int i=0; i<plan->children.size(); i++){
+				requireColumns(plan->children[i].get(), true, set<string>());
+			}
+			return;
+	}
+}
+
+
+Cursor::Cursor(Operator* Root, boost::shared_ptr<QueryArena> Arena, ExecEngine* Engine){
+	//Root may be 0 (unknown relation), giving an empty cursor
+	arena = Arena;
+	root = boost::shared_ptr<Operator>(Root);
+	engine = Engine;
+	row = -1;
+	opened = false;
+	done = (Root==0);
+	failed = (Root==0);
+}
+bool Cursor::next(){
+	//advances to the next tuple, false once the result is exhausted
+	if(done){
+		return false;
+	}
+	if(!opened){
+		opened = true;
+		if(!root->open()){
+			failed = true;
+			finish();
+			return false;
+		}
+	}
+	row++;
+	if(row < batch.size()){
+		return true;
+	}
+	row = 0;
+	if(!root->nextBatch(batch)){
+		finish();
+		return false;
+	}
+	return true;
+}
+void Cursor::finish(){
+	//the query is complete once the cursor is exhausted
+	root->close();
+	engine->finishQuery(arena.get());
+	done = true;
+}
+string Cursor::get(string attrName){
+	return batch.get(root->findColumn(attrName), row).to_string();
+}
+string Cursor::get(int col){
+	return batch.get(col, row).to_string();
+}
+vector<string> Cursor::getTuple(){
+	return batch.getTuple(row);
+}
+vector<string> Cursor::getNames(){
+	if(root==0){
+		return vector<string>();
+	}
+	return root->names;
+}
+void Cursor::print(){
+	//same layout as Relation::print, consumes the cursor. Opens it first, so a query that
+	//can't run prints just its error, not a header
+	bool more = next();
+	if(failed){
+		return;
+	}
+	vector<string> names = getNames();
+	for(int i = 0; i < names.size(); i++) {
+		cout << setw (19)<<names[i];
+	}
+	cout << endl;
+	for(; more; more = next()){
+		for(int j = 0; j < names.size(); j++) {
+			cout << setw (19)<<get(j);
+		}
+		cout << endl;
+	}
+}
+
+
+Query::Query(DBMS* OwnerDBMS, PlanPtr Plan){
+	ownerDBMS = OwnerDBMS;
+	plan = Plan;
+}
+Query& Query::where(Condition cond){
+	plan = makeSelectPlan(cond, plan);
+	return *this;
+}
+Query& Query::project(vector<string> attrList){
+	plan = makeProjectPlan(attrList, plan);
+	return *this;
+}
+Query& Query::project(string attrList){
+	return project(Helpers::splitList(attrList));
+}
+Query& Query::rename(vector<string> attrList){
+	plan = makeRenamePlan(attrList, plan);
+	return *this;
+}
+Query& Query::rename(string attrList){
+	return rename(Helpers::splitList(attrList));
+}
+Query& Query::orderBy(vector<string> attrList){
+	plan = makeOrderPlan(attrList, plan);
+	return *this;
+}
+Query& Query::orderBy(string attrList){
+	return orderBy(Helpers::splitList(attrList));
+}
+Query& Query::limit(int count){
+	plan = makeLimitPlan(count, plan);
+	return *this;
+}
+Query& Query::groupBy(vector<string> attrList, vector<AggregateCall> aggs){
+	plan = makeGroupPlan(attrList, aggs, plan);
+	return *this;
+}
+Query& Query::groupBy(string attrList, vector<AggregateCall> aggs){
+	return groupBy(Helpers::splitList(attrList), aggs);
+}
+Query& Query::groupBy(string attrList, AggregateCall agg){
+	return groupBy(Helpers::splitList(attrList), vector<AggregateCall>(1, agg));
+}
+#ifdef QUERY_INITIALIZER_LISTS
+Query& Query::project(initializer_list<string> attrList){
+	return project(vector<string>(attrList));
+}
+Query& Query::rename(initializer_list<string> attrList){
+	return rename(vector<string>(attrList));
+}
+Query& Query::orderBy(initializer_list<string> attrList){
+	return orderBy(vector<string>(attrList));
+}
+Query& Query::groupBy(initializer_list<string> attrList, vector<AggregateCall> aggs){
+	return groupBy(vector<string>(attrList), aggs);
+}
+Query& Query::groupBy(initializer_list<string> attrList, AggregateCall agg){
+	return groupBy(vector<string>(attrList), vector<AggregateCall>(1, agg));
+}
+#endif
+Query& Query::product(Query right){
+	plan = makeBinaryPlan(ProductPlan, plan, right.getPlan());
+	return *this;
+}
+Query& Query::join(Query right, string leftAttr, string rightAttr){
+	plan = makeJoinPlan(plan, right.getPlan(), leftAttr, rightAttr);
+	return *this;
+}
+Query& Query::unionWith(Query right){
+	plan = makeBinaryPlan(UnionPlan, plan, right.getPlan());
+	return *this;
+}
+Query& Query::difference(Query right){
+	plan = makeBinaryPlan(DifferencePlan, plan, right.getPlan());
+	return *this;
+}
+PlanPtr Query::getPlan(){
+	return plan;
+}
+Cursor Query::run(){
+	return ownerDBMS->execEngine->Open(plan.get());
+}
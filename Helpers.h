@@ -3,6 +3,7 @@
 
 #include <sstream>
 #include <string>
+#include <vector>
 
 namespace Helpers{
 
@@ -39,6 +40,41 @@ namespace Helpers{
 		ss >> i;
 		return i;
 	}
+	
+	
+	unsigned int checksum(const string& bytes, unsigned int hash = 2166136261u){
+		//FNV-1a; pass the previous result as hash to checksum several strings as one
+		for(int i=0; i<bytes.size(); i++){
+			hash = (hash ^ (unsigned char)bytes[i]) * 16777619u;
+		}
+		return hash;
+	}
+	
+	
+	unsigned long long spreadHash(unsigned long long hash){
+		//times 2^64 / golden ratio: spreads nearby keys over the top bits, which pick the bucket
+		//or partition of hash tables
+		return hash * 0x9E3779B97F4A7C15ULL;
+	}
+	
+	
+	vector<string> splitList(string list){
+		//"dvdId, title" -> [dvdId] [title]
+		vector<string> items;
+		string item="";
+		for(int i=0; i<list.size(); i++){
+			if(list[i]==','){
+				items.push_back(item);
+				item="";
+			}else if(list[i]!=' ' && list[i]!='\t'){
+				item+=list[i];
+			}
+		}
+		if(item!=""){
+			items.push_back(item);
+		}
+		return items;
+	}
 }
 
 
@@ -0,0 +1,2135 @@
+#ifndef OPERATORS_H
+#define OPERATORS_H
+
+#include <string>
+#include <vector>
+#include <set>
+#include <climits>
+#include <boost/functional/hash.hpp>
+#include "Relation.h"
+#include "CondConjCompOp.h"
+#include "QueryArena.h"
+#include "TaskPool.h"
+#include "RowSorter.h"
+#include "Aggregation.h"
+
+using namespace std;
+
+//Pull-based query operators. The ExecEngine turns a plan into a tree of these, opens the
+//root, pulls batches until nextBatch() returns false, then closes it. Batches reference
+//cells where they already live instead of copying them, so select/project/rename stream
+//through without building intermediate Relations. Only the final result of a query is
+//copied into a new Relation (materialize()). Anything else an operator has to hold on to
+//comes from the query's arena.
+
+const int BATCH_SIZE = 1024;
+const int MORSEL_ROWS = 16384; //rows per task of a parallel selection, divides ZONE_ROWS
+const int MORSEL_WINDOW = 2; //morsels per thread a parallel selection keeps in flight
+const int JOIN_PARTITION_ROWS = 4096; //right rows per hash join partition, so its table fits in cache
+const int JOIN_MAX_PARTITION_BITS = 14; //at most 2^14 partitions
+const long SORT_MEMORY_DEFAULT = 256L * 1024 * 1024; //bytes an ordering holds before spilling (SET SORT MEMORY)
+const int INDEX_MAX_FRACTION = 10; //a scan reads rows through an index only if at most 1/10 of them match
+
+class Batch{
+//Up to BATCH_SIZE tuples. Only valid until the next nextBatch() call on the operator that filled it.
+public:
+	Relation* src;		//relation holding the cells
+	vector<int> colMap;	//output column i is src->columns[colMap[i]]
+	vector<int> rows;	//row numbers into src
+
+	Batch() {
+		src = 0;
+	}
+
+	int size() {
+		return rows.size();
+	}
+
+	boost::string_ref get(int col, int i) {
+		return src->columns[colMap[col]].getView(rows[i]);
+	}
+
+	vector<string> getTuple(int i) {
+		vector<string> tuple;
+		for(int c = 0; c < colMap.size(); c++) {
+			tuple.push_back(get(c, i).to_string());
+		}
+		return tuple;
+	}
+
+	string tupleKey(int i) {
+		//all cells of tuple i in one string, for duplicate detection
+		string key = "";
+		for(int c = 0; c < colMap.size(); c++) {
+			boost::string_ref cell = get(c, i);
+			key.append(cell.data(), cell.size());
+			key += '\x1f';
+		}
+		return key;
+	}
+};
+
+class Operator{
+public:
+	vector<string> names;	//output schema, known as soon as the operator is constructed
+	vector<DataType> types;
+	QueryArena* arena;		//set by the ExecEngine before open()
+
+	Operator() {
+		arena = 0;
+	}
+	virtual ~Operator() {}
+	virtual bool open() = 0;				//false if the operator cannot run (e.g. unknown attribute)
+	virtual bool nextBatch(Batch& batch) = 0;	//false once there are no more tuples
+	virtual void close() = 0;
+
+	virtual vector<string> sortedBy() {
+		//attributes the tuples come out in ascending order of, most significant first
+		return vector<string>();
+	}
+
+	virtual bool indexOrder(string /*attr*/, bool /*apply*/) {
+		//whether the tuples could come out in ascending order of attr by reading them through a
+		//B+tree index; apply: switch to that order. Only before open()
+		return false;
+	}
+
+	int findColumn(string name) {
+		for(int i = 0; i < names.size(); i++) {
+			if(names[i] == name) {
+				return i;
+			}
+		}
+		return -1;
+	}
+
+	int requireColumn(string name) {
+		//findColumn, reporting an attribute that isn't there
+		int col = findColumn(name);
+		if(col < 0) {
+			cerr << "****| ERROR |**| Attribute " << name << " does not exist |****" << endl;
+		}
+		return col;
+	}
+
+	bool sliceBatch(Relation* rel, int& pos, Batch& batch, const vector<int>* order = 0) {
+		//hands out rel's tuples BATCH_SIZE at a time: the rows from pos on, or order[pos] on if
+		//given, moving pos past them. false once they are all out
+		int height = (order != 0 ? (int)order->size() : (rel->columns.size() == 0 ? 0 : rel->getHeight()));
+		if(pos >= height) {
+			return false;
+		}
+		int end = min(pos + BATCH_SIZE, height);
+		batch.src = rel;
+		batch.colMap.clear();
+		for(int c = 0; c < rel->columns.size(); c++) {
+			batch.colMap.push_back(c);
+		}
+		batch.rows.clear();
+		for(; pos < end; pos++) {
+			batch.rows.push_back(order != 0 ? (*order)[pos] : pos);
+		}
+		return true;
+	}
+
+	void clearOut(Relation* out, long& outBytes) {
+		//empties out, the arena Relation the tuples of the last batch were built in
+		for(int c = 0; c < out->columns.size(); c++) {
+			out->columns[c].clear();
+		}
+		arena->refund(outBytes);
+		outBytes = 0;
+	}
+
+	bool outBatch(Relation* out, Batch& batch) {
+		//the tuples just built in out, false if there are none
+		int pos = 0;
+		return sliceBatch(out, pos, batch);
+	}
+};
+
+long appendBatch(Relation* rel, Batch& batch) {
+	//copies every tuple of batch onto the end of rel, whose columns must match the batch's.
+	//returns the bytes copied
+	long bytes = 0;
+	for(int c = 0; c < batch.colMap.size(); c++) {
+		Attribute& column = batch.src->columns[batch.colMap[c]];
+		Attribute& cells = rel->columns[c];
+		for(int i = 0; i < batch.size(); i++) {
+			boost::string_ref cell = column.getView(batch.rows[i]);
+			cells.addCell(cell);
+			bytes += cellBytes(cell);
+		}
+	}
+	return bytes;
+}
+
+Relation* withSchema(Relation* rel, Operator* op) {
+	rel->addSeveralAttributes(op->names, op->types);
+	return rel;
+}
+
+Relation* materialize(Operator* root, string name) {
+	//runs root to completion, returns 0 if it could not be opened.
+	//The result is not part of root's arena, the caller owns it.
+	if(!root->open()) {
+		root->close();
+		return 0;
+	}
+	Relation* rel = withSchema(new Relation(name), root);
+	Batch batch;
+	while(root->nextBatch(batch)) {
+		root->arena->charge(appendBatch(rel, batch));
+	}
+	root->close();
+	vector<string> order = root->sortedBy();
+	rel->setSortedBy(findSymbols(order));
+	return rel;
+}
+
+
+bool prefixUpperBound(const string& prefix, string& end) {
+	//end: the smallest string greater than every string starting with prefix.
+	//false if there is none (prefix is empty or all '\xff')
+	end = prefix;
+	while(!end.empty() && (unsigned char)end[end.size() - 1] == 0xff) {
+		end.erase(end.size() - 1);
+	}
+	if(end.empty()) {
+		return false;
+	}
+	end[end.size() - 1] = (char)((unsigned char)end[end.size() - 1] + 1);
+	return true;
+}
+
+class ScanOp : public Operator{
+//Only the columns of Rel that are loaded are part of the output.
+public:
+	ScanOp(Relation* Rel, bool Cracking = false) {
+		rel = Rel;
+		cracking = Cracking;
+		pos = 0;
+		filter = 0;
+		indexed = false;
+		exact = false;
+		ordered = false;
+		for(int i = 0; i < rel->columns.size(); i++) {
+			if(rel->columns[i].loaded) {
+				cols.push_back(i);
+				names.push_back(rel->columns[i].name);
+				types.push_back(rel->columns[i].type);
+			}
+		}
+	}
+
+	bool open() {
+		pos = 0;
+		return true;
+	}
+
+	void pruneWith(Condition* Filter) {
+		//only rows that can pass Filter, which must be bound to this scan's schema, need to be read:
+		//bitmap indexes, a value for every primary key attribute, or a selective comparison on a
+		//B+tree indexed (or, when cracking, any INTEGER) column give the rows straight away, otherwise whole ZONE_ROWS blocks whose zone maps show
+		//no row can pass are skipped
+		filter = Filter;
+		if(ordered) {
+			filter = 0; //indexRows must keep their order, the selection checks every row
+			return;
+		}
+		indexed = false;
+		indexRows.clear();
+		if(lookupBitmaps() || lookupPrimaryKey() || lookupIndex() || lookupCracker()) {
+			return;
+		}
+		set<string> read;
+		filter->attributes(read);
+		for(int i = 0; i < cols.size(); i++) {
+			if(read.count(names[i]) != 0) {
+				rel->columns[cols[i]].refreshZones();
+			}
+		}
+	}
+
+	bool nextBatch(Batch& batch) {
+		if(rel->columns.size() == 0) {
+			return false;
+		}
+		batch.src = rel;
+		batch.colMap = cols;
+		batch.rows.clear();
+		if(indexed) {
+			int end = min(pos + BATCH_SIZE, (int)indexRows.size());
+			for(; pos < end; pos++) {
+				batch.rows.push_back(indexRows[pos]);
+			}
+			return batch.size() > 0;
+		}
+		int height = rel->getHeight();
+		while(filter != 0 && pos < height && pos % ZONE_ROWS == 0 && !filter->blockMayPass(rel, cols, pos / ZONE_ROWS)) {
+			pos += ZONE_ROWS;
+			arena->stats.prunedBlocks++;
+		}
+		if(pos >= height) {
+			return false;
+		}
+		int end = min(pos + BATCH_SIZE, height);
+		for(; pos < end; pos++) {
+			batch.rows.push_back(pos);
+		}
+		return true;
+	}
+
+	bool answersFilter() {
+		//true if every row the scan returns passes the filter, so it needn't be checked again
+		return exact;
+	}
+
+	vector<string> sortedBy() {
+		//the relation's order, as far as its attributes are loaded, or the index's
+		vector<string> order;
+		if(ordered) {
+			order.push_back(rel->columns[orderColumn].name);
+			return order;
+		}
+		vector<int> attrIds = rel->sortOrder();
+		for(int i = 0; i < attrIds.size(); i++) {
+			int col = rel->columnIndex(attrIds[i]);
+			if(col == -1 || !rel->columns[col].loaded) {
+				break;
+			}
+			order.push_back(rel->columns[col].name);
+		}
+		return order;
+	}
+
+	bool indexOrder(string attr, bool apply) {
+		int col = rel->columnIndex(symbols().find(attr));
+		if(col == -1 || !rel->columns[col].loaded || rel->findIndex(rel->columns[col].nameId) == 0) {
+			return false;
+		}
+		if(apply) {
+			SecondaryIndex* index = rel->findIndex(rel->columns[col].nameId);
+			index->refresh(rel->columns[col]);
+			indexRows.clear();
+			index->keyOrder(indexRows);
+			indexed = true;
+			ordered = true;
+			orderColumn = col;
+			arena->stats.indexScans++;
+		}
+		return true;
+	}
+
+	bool readsEveryRow() {
+		//false if an index narrowed the scan down to some rows
+		return !indexed;
+	}
+
+	Relation* relation() {
+		return rel;
+	}
+
+	vector<int>& columnMap() {
+		return cols;
+	}
+
+	void close() {}
+
+private:
+	Relation* rel;
+	vector<int> cols;
+	int pos;
+	Condition* filter;
+	bool indexed;			//true: only indexRows are scanned
+	vector<int> indexRows;
+	bool exact;				//true: indexRows are exactly the rows that pass filter
+	bool ordered;			//true: indexRows are every row, in order of column orderColumn (see indexOrder)
+	int orderColumn;
+	bool cracking;			//true: selections crack INTEGER columns that have no B+tree index
+
+	bool lookupBitmaps() {
+		RoaringBitmap rows;
+		if(!filter->bitmapRows(rel, cols, rows, exact)) {
+			exact = false;
+			return false;
+		}
+		if(!exact && rows.size() > rel->getHeight() / INDEX_MAX_FRACTION) {
+			exact = false;
+			return false; //too many rows left to check one by one
+		}
+		rows.rows(indexRows);
+		indexed = true;
+		arena->stats.indexScans++;
+		return true;
+	}
+
+	void conjoined(Condition& cond, vector<Comparison*>& comparisons) {
+		//comparisons every row that passes cond satisfies: those of its only conjunction,
+		//including those of parenthesized conditions that are single conjunctions themselves
+		if(cond.conjunctions.size() != 1) {
+			return;
+		}
+		vector<Comparison>& all = cond.conjunctions[0].comparisons;
+		for(int i = 0; i < all.size(); i++) {
+			if(all[i].isCondition) {
+				conjoined(all[i].cond, comparisons);
+			} else {
+				comparisons.push_back(&all[i]);
+			}
+		}
+	}
+
+	bool lookupPrimaryKey() {
+		//rows of the primary key value that conjoined == comparisons give, if they give one
+		PrimaryKeyIndex* primary = rel->findPrimaryIndex();
+		if(primary == 0) {
+			return false;
+		}
+		vector<Comparison*> comparisons;
+		conjoined(*filter, comparisons);
+		vector<string> values(primary->attrIds.size());
+		vector<bool> given(primary->attrIds.size(), false);
+		for(int i = 0; i < comparisons.size(); i++) {
+			Comparison& comp = *comparisons[i];
+			if(comp.op != Equality || comp.operand1.isAttribute == comp.operand2.isAttribute) {
+				continue;
+			}
+			Operand& attr = (comp.operand1.isAttribute ? comp.operand1 : comp.operand2);
+			int attrId = rel->columns[cols[attr.colIndex]].nameId;
+			for(int k = 0; k < primary->attrIds.size(); k++) {
+				if(primary->attrIds[k] == attrId) {
+					values[k] = (comp.operand1.isAttribute ? comp.operand2 : comp.operand1).val;
+					given[k] = true;
+				}
+			}
+		}
+		if(find(given.begin(), given.end(), false) != given.end()) {
+			return false;
+		}
+		primary->refresh(rel->primaryKeyColumns());
+		primary->lookup(primary->key(values), indexRows);
+		indexed = true;
+		arena->stats.indexScans++;
+		return true;
+	}
+
+	bool lookupIndex() {
+		//every row that passes satisfies each conjoined comparison, so the rows an index
+		//finds for any one of them are enough
+		vector<Comparison*> comparisons;
+		conjoined(*filter, comparisons);
+		int limit = rel->getHeight() / INDEX_MAX_FRACTION;
+		for(int i = 0; i < comparisons.size(); i++) {
+			Comparison& comp = *comparisons[i];
+			if(comp.op == NonEquality || comp.operand1.isAttribute == comp.operand2.isAttribute || (comp.op == Prefix && !comp.operand1.isAttribute)) {
+				continue;
+			}
+			Operand& attr = (comp.operand1.isAttribute ? comp.operand1 : comp.operand2);
+			string* literal = &(comp.operand1.isAttribute ? comp.operand2 : comp.operand1).val;
+			Attribute& column = rel->columns[cols[attr.colIndex]];
+			SecondaryIndex* index = rel->findIndex(column.nameId);
+			if(index == 0 || (comp.op == Prefix && index->isInt)) {
+				continue;
+			}
+			index->refresh(column);
+			Operation op = (comp.operand1.isAttribute ? comp.op : mirrorOp(comp.op));
+			string* low = (op == Equality || op == GreaterThan || op == GreaterThanEqual || op == Prefix ? literal : 0);
+			string* high = (op == Equality || op == LessThan || op == LessThanEqual ? literal : 0);
+			string prefixEnd;
+			if(op == Prefix && prefixUpperBound(*literal, prefixEnd)) {
+				high = &prefixEnd; //exclusive, everything starting with the literal sorts before it
+			}
+			indexRows.clear();
+			if(index->lookup(low, op != GreaterThan, high, op != LessThan && op != Prefix, limit, indexRows)) {
+				indexed = true;
+				arena->stats.indexScans++;
+				return true;
+			}
+		}
+		indexRows.clear();
+		return false;
+	}
+
+	bool lookupCracker() {
+		//like lookupIndex, through (and cracking) the cracker index of the first INTEGER column
+		//compared with a literal, narrowed by every conjoined comparison on that column
+		if(!cracking) {
+			return false;
+		}
+		vector<Comparison*> comparisons;
+		conjoined(*filter, comparisons);
+		int column = -1;
+		long long low = INT_MIN;					//as a half-open range [low, high) of ints
+		long long high = (long long)INT_MAX + 1;
+		for(int i = 0; i < comparisons.size(); i++) {
+			Comparison& comp = *comparisons[i];
+			if(!comp.intFlag || comp.op == NonEquality || comp.operand1.isAttribute == comp.operand2.isAttribute) {
+				continue;
+			}
+			Operand& attr = (comp.operand1.isAttribute ? comp.operand1 : comp.operand2);
+			long long literal = (comp.operand1.isAttribute ? comp.operand2 : comp.operand1).ival;
+			if(column == -1) {
+				if(rel->findIndex(rel->columns[cols[attr.colIndex]].nameId) != 0) {
+					continue;
+				}
+				column = cols[attr.colIndex];
+			} else if(cols[attr.colIndex] != column) {
+				continue;
+			}
+			switch(comp.operand1.isAttribute ? comp.op : mirrorOp(comp.op)) {
+				case Equality:			low = max(low, literal); high = min(high, literal + 1); break;
+				case LessThan:			high = min(high, literal); break;
+				case LessThanEqual:		high = min(high, literal + 1); break;
+				case GreaterThan:		low = max(low, literal + 1); break;
+				case GreaterThanEqual:	low = max(low, literal); break;
+				default:				break;
+			}
+		}
+		if(column == -1) {
+			return false;
+		}
+		CrackerIndex* cracker = rel->findCracker(rel->columns[column].nameId);
+		if(cracker == 0) {
+			rel->crackers.push_back(CrackerIndex(rel->columns[column]));
+			cracker = &rel->crackers.back();
+		}
+		cracker->refresh(rel->columns[column]);
+		int cracked = 0;
+		bool found = cracker->range(low, high, rel->getHeight() / INDEX_MAX_FRACTION, indexRows, cracked);
+		arena->stats.cracks += cracked; //even if too many rows match, the next selection gains from the cracks
+		if(!found) {
+			return false;
+		}
+		indexed = true;
+		arena->stats.indexScans++;
+		return true;
+	}
+};
+
+class SelectOp : public Operator{
+//With more than one thread in the pool, a selection straight over a full scan is morsel
+//driven: every MORSEL_ROWS rows are a task, which checks them with its own copy of the
+//condition, and the rows that pass are returned morsel by morsel, so in scan order.
+//At most MORSEL_WINDOW morsels per thread are in flight: each one handed out makes room for
+//the next, so a parent that stops pulling early (limit) leaves the rest of the scan unchecked.
+public:
+	SelectOp(Operator* Child, Condition Cond, TaskPool* Pool = 0) {
+		child = Child;
+		cond = Cond;
+		pool = Pool;
+		checked = true;
+		parallel = false;
+		names = child->names;
+		types = child->types;
+	}
+
+	~SelectOp() {
+		dropMorsels();
+		delete child;
+	}
+
+	bool open() {
+		vector<int> nameIds = findSymbols(names);
+		if(!child->open() || !cond.bind(nameIds, types)) {
+			return false;
+		}
+		ScanOp* scan = dynamic_cast<ScanOp*>(child);
+		parallel = false;
+		if(scan != 0) {
+			scan->pruneWith(&cond);
+			checked = !scan->answersFilter();
+			parallel = (pool != 0 && pool->threads() > 1 && checked && scan->readsEveryRow());
+		}
+		if(parallel) {
+			startMorsels(scan);
+		}
+		return true;
+	}
+
+	bool nextBatch(Batch& batch) {
+		if(parallel) {
+			return nextMorselBatch(batch);
+		}
+		if(!checked) {
+			return child->nextBatch(batch);
+		}
+		//pull until some tuple passes, so parents never see empty batches
+		while(child->nextBatch(input)) {
+			batch.src = input.src;
+			batch.colMap = input.colMap;
+			batch.rows.clear();
+			for(int i = 0; i < input.size(); i++) {
+				if(cond.passes(input.src, input.colMap, input.rows[i])) {
+					batch.rows.push_back(input.rows[i]);
+				}
+			}
+			if(batch.size() > 0) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	vector<string> sortedBy() {
+		return child->sortedBy();
+	}
+
+	bool indexOrder(string attr, bool apply) {
+		return child->indexOrder(attr, apply);
+	}
+
+	void close() {
+		dropMorsels();
+		child->close();
+	}
+
+private:
+	Operator* child;
+	Condition cond;
+	bool checked;	//false: the child only returns tuples that pass (see ScanOp::answersFilter)
+	Batch input;
+	TaskPool* pool;
+	bool parallel;	//true: the rows that pass are found by morsel tasks
+	Relation* rel;	//what the scan reads, when parallel
+	vector<int> cols;
+	vector< vector<int> > morselRows;	//rows of each morsel that pass
+	vector<char> morselPruned;	//1 if the morsel was skipped thanks to its block's zone maps
+	vector<TaskGroup*> slots;	//morsel i runs in slots[i % slots.size()], one at a time
+	int morselsSubmitted;
+	int morselsDone;	//morsels waited for, whose rows can be returned
+	int nextMorsel;	//next one to return
+	int morselPos;	//next row of morselRows[nextMorsel] to return
+
+	void startMorsels(ScanOp* scan) {
+		dropMorsels();
+		rel = scan->relation();
+		cols = scan->columnMap();
+		int height = (rel->columns.size() == 0 ? 0 : rel->getHeight());
+		int morsels = (height + MORSEL_ROWS - 1) / MORSEL_ROWS;
+		morselRows.assign(morsels, vector<int>());
+		morselPruned.assign(morsels, 0);
+		for(int i = 0; i < MORSEL_WINDOW * pool->threads(); i++) {
+			slots.push_back(new TaskGroup());
+		}
+		morselsSubmitted = 0;
+		morselsDone = 0;
+		nextMorsel = 0;
+		morselPos = 0;
+		while(morselsSubmitted < min((int)slots.size(), morsels)) {
+			submitMorsel();
+		}
+	}
+
+	void submitMorsel() {
+		int morsel = morselsSubmitted++;
+		pool->submit(*slots[morsel % slots.size()], boost::bind(&SelectOp::scanMorsel, this, morsel));
+	}
+
+	void finishMorsel() {
+		//waits for morsel morselsDone, then submits the first one not submitted yet in its slot
+		int morsel = morselsDone++;
+		TaskGroup& slot = *slots[morsel % slots.size()];
+		pool->wait(slot);
+		arena->stats.tasks += slot.tasks;
+		arena->stats.stolenTasks += slot.stolen;
+		slot.tasks = 0;
+		slot.stolen = 0;
+		if(morselPruned[morsel] && (morsel * MORSEL_ROWS) % ZONE_ROWS == 0) {
+			arena->stats.prunedBlocks++;
+		}
+		arena->charge((long)morselRows[morsel].size() * sizeof(int));
+		if(morselsSubmitted < morselRows.size()) {
+			submitMorsel();
+		}
+	}
+
+	void dropMorsels() {
+		//waits for the morsels still in flight, whose rows nobody asked for
+		for(int i = 0; i < slots.size(); i++) {
+			try {
+				pool->wait(*slots[i]);
+			} catch(...) {
+				//their errors are dropped with them
+			}
+			delete slots[i];
+		}
+		slots.clear();
+	}
+
+	void scanMorsel(int morsel) {
+		//one task: the comparisons of cond cache things in passes(), so each task uses a copy
+		Condition local = cond;
+		int start = morsel * MORSEL_ROWS;
+		int end = min(start + MORSEL_ROWS, rel->getHeight());
+		if(!local.blockMayPass(rel, cols, start / ZONE_ROWS)) {
+			morselPruned[morsel] = 1;
+			return;
+		}
+		vector<int>& passed = morselRows[morsel];
+		for(int row = start; row < end; row++) {
+			if(local.passes(rel, cols, row)) {
+				passed.push_back(row);
+			}
+		}
+	}
+
+	bool nextMorselBatch(Batch& batch) {
+		batch.src = rel;
+		batch.colMap = cols;
+		batch.rows.clear();
+		while(batch.size() < BATCH_SIZE && nextMorsel < morselRows.size()) {
+			if(nextMorsel == morselsDone) {
+				if(batch.size() > 0) {
+					break; //rather than wait for another morsel
+				}
+				finishMorsel();
+			}
+			vector<int>& passed = morselRows[nextMorsel];
+			int end = min(morselPos + BATCH_SIZE - batch.size(), (int)passed.size());
+			batch.rows.insert(batch.rows.end(), passed.begin() + morselPos, passed.begin() + end);
+			morselPos = end;
+			if(morselPos == passed.size()) {
+				arena->refund((long)passed.size() * sizeof(int));
+				vector<int>().swap(passed);
+				nextMorsel++;
+				morselPos = 0;
+			}
+		}
+		return batch.size() > 0;
+	}
+};
+
+class ProjectOp : public Operator{
+public:
+	ProjectOp(Operator* Child, vector<string> attrList) {
+		child = Child;
+		for(int i = 0; i < attrList.size(); i++) {
+			int pos = child->findColumn(attrList[i]);
+			positions.push_back(pos);
+			names.push_back(attrList[i]);
+			types.push_back(pos >= 0 ? child->types[pos] : DataType(false));
+		}
+	}
+
+	~ProjectOp() {
+		delete child;
+	}
+
+	bool open() {
+		for(int i = 0; i < positions.size(); i++) {
+			if(positions[i] < 0) {
+				return false;
+			}
+		}
+		return child->open();
+	}
+
+	bool nextBatch(Batch& batch) {
+		if(!child->nextBatch(batch)) {
+			return false;
+		}
+		vector<int> colMap;
+		for(int i = 0; i < positions.size(); i++) {
+			colMap.push_back(batch.colMap[positions[i]]);
+		}
+		batch.colMap = colMap;
+		return true;
+	}
+
+	vector<string> sortedBy() {
+		//the child's order up to its first attribute that isn't kept
+		vector<string> order = child->sortedBy();
+		for(int i = 0; i < order.size(); i++) {
+			if(findColumn(order[i]) == -1) {
+				order.resize(i);
+			}
+		}
+		return order;
+	}
+
+	bool indexOrder(string attr, bool apply) {
+		return findColumn(attr) != -1 && child->indexOrder(attr, apply);
+	}
+
+	void close() {
+		child->close();
+	}
+
+private:
+	Operator* child;
+	vector<int> positions; //child column of each output column
+};
+
+class RenameOp : public Operator{
+public:
+	RenameOp(Operator* Child, vector<string> newNames) {
+		child = Child;
+		names = newNames;
+		types = child->types;
+	}
+
+	~RenameOp() {
+		delete child;
+	}
+
+	bool open() {
+		return names.size() == child->names.size() && child->open();
+	}
+
+	bool nextBatch(Batch& batch) {
+		return child->nextBatch(batch);
+	}
+
+	vector<string> sortedBy() {
+		vector<string> order = child->sortedBy();
+		if(names.size() != child->names.size()) {
+			return vector<string>();
+		}
+		for(int i = 0; i < order.size(); i++) {
+			order[i] = names[child->findColumn(order[i])];
+		}
+		return order;
+	}
+
+	bool indexOrder(string attr, bool apply) {
+		int pos = findColumn(attr);
+		return pos != -1 && child->indexOrder(child->names[pos], apply);
+	}
+
+	void close() {
+		child->close();
+	}
+
+private:
+	Operator* child;
+};
+
+class ProductOp : public Operator{
+//Nested loops: right is read once into an arena Relation, left is streamed.
+public:
+	ProductOp(Operator* Left, Operator* Right) {
+		left = Left;
+		right = Right;
+		rightRel = 0;
+		out = 0;
+		outBytes = 0;
+		names = left->names;
+		types = left->types;
+		names.insert(names.end(), right->names.begin(), right->names.end());
+		types.insert(types.end(), right->types.begin(), right->types.end());
+	}
+
+	~ProductOp() {
+		delete left;
+		delete right;
+	}
+
+	bool open() {
+		if(!left->open() || !right->open()) {
+			return false;
+		}
+		rightRel = withSchema(arena->newRelation("productRight"), right);
+		Batch batch;
+		while(right->nextBatch(batch)) {
+			arena->charge(appendBatch(rightRel, batch));
+		}
+		out = withSchema(arena->newRelation("product"), this);
+		leftI = 0;
+		rightI = 0;
+		return true;
+	}
+
+	bool nextBatch(Batch& batch) {
+		if(rightRel->columns.size() == 0 || rightRel->getHeight() == 0) {
+			return false;
+		}
+		clearOut(out, outBytes);
+		int count = 0;
+		while(count < BATCH_SIZE) {
+			if(leftI >= leftBatch.size()) {
+				if(!left->nextBatch(leftBatch)) {
+					break;
+				}
+				leftI = 0;
+				rightI = 0;
+			}
+			int lCols = leftBatch.colMap.size();
+			for(int c = 0; c < lCols; c++) {
+				out->columns[c].addCell(leftBatch.get(c, leftI));
+				outBytes += cellBytes(leftBatch.get(c, leftI));
+			}
+			for(int c = 0; c < rightRel->columns.size(); c++) {
+				out->columns[lCols + c].addCell(rightRel->columns[c].getView(rightI));
+				outBytes += cellBytes(rightRel->columns[c].getView(rightI));
+			}
+			count++;
+			rightI++;
+			if(rightI >= rightRel->getHeight()) {
+				rightI = 0;
+				leftI++;
+			}
+		}
+		arena->charge(outBytes);
+		return outBatch(out, batch);
+	}
+
+	vector<string> sortedBy() {
+		//every left tuple's pairs come out together, in left's order
+		return left->sortedBy();
+	}
+
+	void close() {
+		//rightRel and out belong to the arena
+		left->close();
+		right->close();
+	}
+
+private:
+	Operator* left;
+	Operator* right;
+	Relation* rightRel;	//all of right's tuples
+	Relation* out;		//cells of the batch last handed out
+	long outBytes;
+	Batch leftBatch;
+	int leftI;
+	int rightI;
+};
+
+class HashJoinOp : public Operator{
+//Equi-join, left join ( leftAttr == rightAttr ) right, radix partitioned: both inputs are read
+//into arena Relations, and the rows of each side are scattered by the top bits of their key's
+//hash into partitions of about JOIN_PARTITION_ROWS right rows, small enough for one
+//partition's hash table to stay in cache. Hashing, counting and scattering run one task per
+//MORSEL_ROWS rows, then one task per partition builds a hash table over its right rows and
+//probes it with its left rows. Matches come out ordered by left row, then right row, the
+//order select ( leftAttr == rightAttr ) ( left * right ) gives them in.
+public:
+	HashJoinOp(Operator* Left, Operator* Right, string LeftAttr, string RightAttr, TaskPool* Pool) {
+		left = Left;
+		right = Right;
+		leftAttr = LeftAttr;
+		rightAttr = RightAttr;
+		pool = Pool;
+		out = 0;
+		outBytes = 0;
+		names = left->names;
+		types = left->types;
+		names.insert(names.end(), right->names.begin(), right->names.end());
+		types.insert(types.end(), right->types.begin(), right->types.end());
+	}
+
+	~HashJoinOp() {
+		delete left;
+		delete right;
+	}
+
+	bool open() {
+		leftSide.keyCol = left->requireColumn(leftAttr);
+		rightSide.keyCol = (leftSide.keyCol < 0 ? -1 : right->requireColumn(rightAttr));
+		if(rightSide.keyCol < 0 || !left->open() || !right->open()) {
+			return false;
+		}
+		//compared the way == compares them: as integers if the left attribute is an INTEGER
+		intKeys = left->types[leftSide.keyCol].isInt();
+		leftSide.rel = readInput(left, "joinLeft");
+		rightSide.rel = readInput(right, "joinRight");
+		int rightRows = rightSide.rel->getHeight();
+		bits = 0;
+		while(bits < JOIN_MAX_PARTITION_BITS && ((long)JOIN_PARTITION_ROWS << bits) < rightRows) {
+			bits++;
+		}
+		partitions = 1 << bits;
+		arena->stats.joinPartitions += partitions;
+		partition(leftSide);
+		partition(rightSide);
+		matches.assign(partitions, vector< pair<int, int> >());
+		TaskGroup group;
+		for(int p = 0; p < partitions; p++) {
+			pool->submit(group, boost::bind(&HashJoinOp::joinPartition, this, p));
+		}
+		pool->wait(group);
+		addStats(group);
+		orderMatches();
+		out = withSchema(arena->newRelation("join"), this);
+		nextMatch = 0;
+		return true;
+	}
+
+	bool nextBatch(Batch& batch) {
+		if(nextMatch >= matchLeft.size()) {
+			return false;
+		}
+		clearOut(out, outBytes);
+		int count = min(BATCH_SIZE, (int)matchLeft.size() - nextMatch);
+		int lCols = leftSide.rel->columns.size();
+		for(int c = 0; c < out->columns.size(); c++) {
+			Attribute& column = (c < lCols ? leftSide.rel->columns[c] : rightSide.rel->columns[c - lCols]);
+			vector<int>& rows = (c < lCols ? matchLeft : matchRight);
+			for(int i = nextMatch; i < nextMatch + count; i++) {
+				boost::string_ref cell = column.getView(rows[i]);
+				out->columns[c].addCell(cell);
+				outBytes += cellBytes(cell);
+			}
+		}
+		arena->charge(outBytes);
+		nextMatch += count;
+		return outBatch(out, batch);
+	}
+
+	vector<string> sortedBy() {
+		//every left tuple's pairs come out together, in left's order
+		return left->sortedBy();
+	}
+
+	void close() {
+		//the inputs and out belong to the arena
+		left->close();
+		right->close();
+	}
+
+private:
+	struct JoinSide{
+		Relation* rel;		//all of the input's tuples
+		int keyCol;			//column of the join attribute
+		vector<unsigned long long> hashes;	//hash of every row's key
+		vector<int> keys;	//every row's key, for INTEGER keys
+		vector<int> chunkCounts;	//rows of every chunk of MORSEL_ROWS rows in every partition
+		vector<int> partitionStart;	//rows[partitionStart[p]] is partition p's first row
+		vector<int> rows;	//row numbers grouped by partition, in row order within one
+	};
+
+	Operator* left;
+	Operator* right;
+	string leftAttr;
+	string rightAttr;
+	TaskPool* pool;
+	bool intKeys;
+	int bits;			//partition: top bits of the hash
+	int partitions;
+	JoinSide leftSide;
+	JoinSide rightSide;
+	vector< vector< pair<int, int> > > matches;	//(left row, right row) found in every partition
+	vector<int> matchLeft;	//every match, ordered by left row then right row
+	vector<int> matchRight;
+	int nextMatch;		//next one to return
+	Relation* out;		//cells of the batch last handed out
+	long outBytes;
+
+	Relation* readInput(Operator* input, string name) {
+		Relation* rel = withSchema(arena->newRelation(name), input);
+		Batch batch;
+		while(input->nextBatch(batch)) {
+			arena->charge(appendBatch(rel, batch));
+		}
+		return rel;
+	}
+
+	void addStats(TaskGroup& group) {
+		arena->stats.tasks += group.tasks;
+		arena->stats.stolenTasks += group.stolen;
+	}
+
+	int chunks(JoinSide& side) {
+		return (side.rel->getHeight() + MORSEL_ROWS - 1) / MORSEL_ROWS;
+	}
+
+	void partition(JoinSide& side) {
+		//hashes every row and counts each chunk's rows per partition, then, once the counts
+		//give every chunk its place in each partition, scatters the rows there
+		int height = side.rel->getHeight();
+		side.hashes.resize(height);
+		side.keys.resize(intKeys ? height : 0);
+		side.chunkCounts.assign((long)chunks(side) * partitions, 0);
+		side.rows.resize(height);
+		arena->charge((long)height * (sizeof(unsigned long long) + 2 * sizeof(int)));
+		TaskGroup hashing;
+		for(int i = 0; i < chunks(side); i++) {
+			pool->submit(hashing, boost::bind(&HashJoinOp::hashChunk, this, &side, i));
+		}
+		pool->wait(hashing);
+		addStats(hashing);
+		//chunkCounts becomes each chunk's first position in each partition
+		side.partitionStart.assign(partitions + 1, 0);
+		int position = 0;
+		for(int p = 0; p < partitions; p++) {
+			side.partitionStart[p] = position;
+			for(int i = 0; i < chunks(side); i++) {
+				int count = side.chunkCounts[(long)i * partitions + p];
+				side.chunkCounts[(long)i * partitions + p] = position;
+				position += count;
+			}
+		}
+		side.partitionStart[partitions] = position;
+		TaskGroup scattering;
+		for(int i = 0; i < chunks(side); i++) {
+			pool->submit(scattering, boost::bind(&HashJoinOp::scatterChunk, this, &side, i));
+		}
+		pool->wait(scattering);
+		addStats(scattering);
+	}
+
+	int partitionOf(unsigned long long hash) {
+		return (bits == 0 ? 0 : (int)(hash >> (64 - bits)));
+	}
+
+	void hashChunk(JoinSide* side, int chunk) {
+		//one task: key, hash and partition counts of the chunk's rows
+		Attribute& column = side->rel->columns[side->keyCol];
+		int* counts = &side->chunkCounts[(long)chunk * partitions];
+		int end = min((chunk + 1) * MORSEL_ROWS, side->rel->getHeight());
+		for(int row = chunk * MORSEL_ROWS; row < end; row++) {
+			unsigned long long hash;
+			if(intKeys) {
+				side->keys[row] = column.getInt(row);
+				hash = (unsigned int)side->keys[row];
+			} else {
+				boost::string_ref cell = column.getView(row);
+				hash = boost::hash_range(cell.begin(), cell.end());
+			}
+			hash = Helpers::spreadHash(hash);
+			side->hashes[row] = hash;
+			counts[partitionOf(hash)]++;
+		}
+	}
+
+	void scatterChunk(JoinSide* side, int chunk) {
+		//one task: the chunk's rows into the places partition() reserved for them
+		int* next = &side->chunkCounts[(long)chunk * partitions];
+		int end = min((chunk + 1) * MORSEL_ROWS, side->rel->getHeight());
+		for(int row = chunk * MORSEL_ROWS; row < end; row++) {
+			side->rows[next[partitionOf(side->hashes[row])]++] = row;
+		}
+	}
+
+	bool sameKey(int leftRow, int rightRow) {
+		if(intKeys) {
+			return leftSide.keys[leftRow] == rightSide.keys[rightRow];
+		}
+		return leftSide.rel->columns[leftSide.keyCol].getView(leftRow) == rightSide.rel->columns[rightSide.keyCol].getView(rightRow);
+	}
+
+	void joinPartition(int p) {
+		//one task: a chained hash table over the partition's right rows, probed with its left rows
+		int rightStart = rightSide.partitionStart[p];
+		int rightCount = rightSide.partitionStart[p + 1] - rightStart;
+		if(rightCount == 0) {
+			return;
+		}
+		int buckets = 1;
+		while(buckets < 2 * rightCount) {
+			buckets *= 2;
+		}
+		vector<int> head(buckets, -1);
+		vector<int> next(rightCount);
+		for(int i = rightCount - 1; i >= 0; i--) {
+			//added backwards, so every chain lists its rows in row order
+			int bucket = (int)(rightSide.hashes[rightSide.rows[rightStart + i]] >> 16) & (buckets - 1);
+			next[i] = head[bucket];
+			head[bucket] = i;
+		}
+		vector< pair<int, int> >& found = matches[p];
+		for(int j = leftSide.partitionStart[p]; j < leftSide.partitionStart[p + 1]; j++) {
+			int leftRow = leftSide.rows[j];
+			unsigned long long hash = leftSide.hashes[leftRow];
+			for(int i = head[(int)(hash >> 16) & (buckets - 1)]; i >= 0; i = next[i]) {
+				int rightRow = rightSide.rows[rightStart + i];
+				if(rightSide.hashes[rightRow] == hash && sameKey(leftRow, rightRow)) {
+					found.push_back(make_pair(leftRow, rightRow));
+				}
+			}
+		}
+	}
+
+	void orderMatches() {
+		//counting sort of the matches by left row. Every left row is in one partition, where
+		//its matches are already next to each other and in right row order
+		vector<int> first(leftSide.rel->getHeight() + 1, 0);
+		long total = 0;
+		for(int p = 0; p < partitions; p++) {
+			for(int i = 0; i < matches[p].size(); i++) {
+				first[matches[p][i].first + 1]++;
+			}
+			total += matches[p].size();
+		}
+		for(int row = 0; row < leftSide.rel->getHeight(); row++) {
+			first[row + 1] += first[row];
+		}
+		matchLeft.resize(total);
+		matchRight.resize(total);
+		arena->charge(total * 2 * sizeof(int));
+		for(int p = 0; p < partitions; p++) {
+			for(int i = 0; i < matches[p].size(); i++) {
+				int at = first[matches[p][i].first]++;
+				matchLeft[at] = matches[p][i].first;
+				matchRight[at] = matches[p][i].second;
+			}
+			vector< pair<int, int> >().swap(matches[p]);
+		}
+	}
+};
+
+class MergeJoinOp : public Operator{
+//Equi-join of two inputs that both come out in ascending order of their join attribute (see
+//Operator::sortedBy and indexOrder), in one pass over each: the right tuples of one key at a
+//time are copied into an arena Relation and paired with every left tuple of that key, so
+//unlike HashJoinOp it holds no more than one key's right tuples however large the inputs.
+//Both join attributes must be INTEGER, or both VARCHAR, for the two orders to agree.
+public:
+	MergeJoinOp(Operator* Left, Operator* Right, string LeftAttr, string RightAttr) {
+		left = Left;
+		right = Right;
+		leftAttr = LeftAttr;
+		rightAttr = RightAttr;
+		group = 0;
+		out = 0;
+		groupBytes = 0;
+		outBytes = 0;
+		names = left->names;
+		types = left->types;
+		names.insert(names.end(), right->names.begin(), right->names.end());
+		types.insert(types.end(), right->types.begin(), right->types.end());
+	}
+
+	~MergeJoinOp() {
+		delete left;
+		delete right;
+	}
+
+	bool open() {
+		leftKey = left->requireColumn(leftAttr);
+		rightKey = (leftKey < 0 ? -1 : right->requireColumn(rightAttr));
+		if(rightKey < 0 || !left->open() || !right->open()) {
+			return false;
+		}
+		intKeys = left->types[leftKey].isInt();
+		group = withSchema(arena->newRelation("mergeGroup"), right);
+		out = withSchema(arena->newRelation("join"), this);
+		leftBatch = Batch();
+		rightBatch = Batch();
+		leftI = 0;
+		rightI = 0;
+		leftDone = false;
+		rightDone = false;
+		haveGroup = false;
+		pairing = false;
+		arena->stats.mergeJoins++;
+		return true;
+	}
+
+	bool nextBatch(Batch& batch) {
+		clearOut(out, outBytes);
+		int count = 0;
+		while(count < BATCH_SIZE && nextLeft()) {
+			if(pairing) {
+				int lCols = leftBatch.colMap.size();
+				for(int c = 0; c < lCols; c++) {
+					out->columns[c].addCell(leftBatch.get(c, leftI));
+					outBytes += cellBytes(leftBatch.get(c, leftI));
+				}
+				for(int c = 0; c < group->columns.size(); c++) {
+					out->columns[lCols + c].addCell(group->columns[c].getView(groupPos));
+					outBytes += cellBytes(group->columns[c].getView(groupPos));
+				}
+				count++;
+				groupPos++;
+				if(groupPos >= group->getHeight()) {
+					pairing = false;
+					leftI++;
+				}
+				continue;
+			}
+			int order = (haveGroup ? compareKeys(leftColumn(), leftBatch.rows[leftI], group->columns[rightKey], 0) : 1);
+			if(order > 0) {
+				if(!nextGroup()) {
+					leftDone = true; //right is exhausted, no other left tuple can match
+				}
+			} else if(order == 0) {
+				pairing = true;
+				groupPos = 0;
+			} else {
+				leftI++;
+			}
+		}
+		arena->charge(outBytes);
+		return outBatch(out, batch);
+	}
+
+	vector<string> sortedBy() {
+		return left->sortedBy();
+	}
+
+	void close() {
+		//group and out belong to the arena
+		left->close();
+		right->close();
+	}
+
+private:
+	Operator* left;
+	Operator* right;
+	string leftAttr;
+	string rightAttr;
+	int leftKey;		//column of the join attribute in each input
+	int rightKey;
+	bool intKeys;
+	Batch leftBatch;
+	Batch rightBatch;
+	int leftI;			//current tuple of each batch
+	int rightI;
+	bool leftDone;
+	bool rightDone;
+	Relation* group;	//right tuples of the current key
+	bool haveGroup;
+	bool pairing;		//true: the current left tuple is being paired with group's tuples
+	int groupPos;		//next of them
+	Relation* out;		//cells of the batch last handed out
+	long groupBytes;
+	long outBytes;
+
+	bool nextLeft() {
+		//leftI on a tuple of leftBatch, false once left is exhausted
+		while(!leftDone && leftI >= leftBatch.size()) {
+			leftDone = !left->nextBatch(leftBatch);
+			leftI = 0;
+		}
+		return !leftDone;
+	}
+
+	bool nextRight() {
+		while(!rightDone && rightI >= rightBatch.size()) {
+			rightDone = !right->nextBatch(rightBatch);
+			rightI = 0;
+		}
+		return !rightDone;
+	}
+
+	Attribute& leftColumn() {
+		return leftBatch.src->columns[leftBatch.colMap[leftKey]];
+	}
+
+	Attribute& rightColumn() {
+		return rightBatch.src->columns[rightBatch.colMap[rightKey]];
+	}
+
+	int compareKeys(Attribute& x, int xRow, Attribute& y, int yRow) {
+		//<0, 0 or >0 as x's key sorts before, with or after y's
+		return (intKeys ? compareInts(x.getInt(xRow), y.getInt(yRow)) : x.getView(xRow).compare(y.getView(yRow)));
+	}
+
+	bool nextGroup() {
+		//the right tuples of the smallest key that isn't below the current left tuple's,
+		//false once right is exhausted
+		for(int c = 0; c < group->columns.size(); c++) {
+			group->columns[c].clear();
+		}
+		arena->refund(groupBytes);
+		groupBytes = 0;
+		haveGroup = false;
+		while(nextRight() && compareKeys(rightColumn(), rightBatch.rows[rightI], leftColumn(), leftBatch.rows[leftI]) < 0) {
+			rightI++;
+		}
+		if(rightDone) {
+			return false;
+		}
+		do {
+			for(int c = 0; c < group->columns.size(); c++) {
+				group->columns[c].addCell(rightBatch.get(c, rightI));
+				groupBytes += cellBytes(rightBatch.get(c, rightI));
+			}
+			rightI++;
+		} while(nextRight() && compareKeys(rightColumn(), rightBatch.rows[rightI], group->columns[rightKey], 0) == 0);
+		arena->charge(groupBytes);
+		haveGroup = true;
+		return true;
+	}
+};
+
+class OrderOp : public Operator{
+//order ( attribute-list ) expr: the input is read into an arena Relation and a permutation
+//of its rows is sorted by the attributes (see RowSorter), ties keeping the input's order.
+//Batches hand out the rows in the permutation's order, so the cells never move.
+//An input that already comes out in order of the attributes (sortedBy) is passed through.
+//Once the rows read hold more than memoryLimit bytes, they are sorted and written to a
+//temporary run file in tempDir, and reading goes on into an emptied Relation. At the end
+//all the runs are merged through a heap of their current tuples, those of earlier runs
+//first among equal ones so the sort stays stable, and the files are removed.
+public:
+	OrderOp(Operator* Child, vector<string> Attrs, TaskPool* Pool, long MemoryLimit, string TempDir) {
+		child = Child;
+		attrs = Attrs;
+		pool = Pool;
+		memoryLimit = MemoryLimit;
+		tempDir = TempDir;
+		rel = 0;
+		passThrough = false;
+		out = 0;
+		outBytes = 0;
+		names = child->names;
+		types = child->types;
+	}
+
+	~OrderOp() {
+		removeRuns();
+		delete child;
+	}
+
+	bool open() {
+		removeRuns();
+		keyCols.clear();
+		for(int i = 0; i < attrs.size(); i++) {
+			keyCols.push_back(requireColumn(attrs[i]));
+			if(keyCols.back() < 0) {
+				return false;
+			}
+		}
+		if(!child->open()) {
+			return false;
+		}
+		vector<string> childOrder = child->sortedBy();
+		passThrough = (childOrder.size() >= attrs.size() && equal(attrs.begin(), attrs.end(), childOrder.begin()));
+		if(passThrough) {
+			return true;
+		}
+		rel = withSchema(arena->newRelation("order"), child);
+		long runBytes = 0;
+		Batch batch;
+		while(child->nextBatch(batch)) {
+			long bytes = appendBatch(rel, batch);
+			arena->charge(bytes);
+			runBytes += bytes;
+			if(runBytes > memoryLimit) {
+				if(!spillRun()) {
+					return false;
+				}
+				arena->refund(runBytes);
+				runBytes = 0;
+			}
+		}
+		if(!runFiles.empty()) {
+			if(rel->getHeight() > 0 && !spillRun()) {
+				return false;
+			}
+			arena->refund(runBytes);
+			return startMerge();
+		}
+		sortRows();
+		arena->charge(order.size() * sizeof(int));
+		pos = 0;
+		return true;
+	}
+
+	bool nextBatch(Batch& batch) {
+		if(passThrough) {
+			return child->nextBatch(batch);
+		}
+		if(!readers.empty()) {
+			return nextMergedBatch(batch);
+		}
+		return sliceBatch(rel, pos, batch, &order);
+	}
+
+	vector<string> sortedBy() {
+		return attrs;
+	}
+
+	void close() {
+		//rel and out belong to the arena
+		removeRuns();
+		child->close();
+	}
+
+private:
+	Operator* child;
+	vector<string> attrs;	//sort keys, most significant first
+	vector<int> keyCols;	//their columns
+	TaskPool* pool;
+	long memoryLimit;		//bytes of cells read before a run is written out
+	string tempDir;
+	Relation* rel;			//the input's tuples (of the current run, when spilling)
+	vector<int> order;		//rows of rel, sorted
+	int pos;				//next of them to return
+	bool passThrough;		//the child's tuples are in order already and handed on as they come
+	vector<string> runFiles;
+	vector<SortRunReader*> readers;	//one per run while merging
+	vector<int> heap;		//runs whose current tuple hasn't been returned, smallest on top
+	Relation* out;			//cells of the merged batch last handed out
+	long outBytes;
+
+	void sortRows() {
+		order.resize(rel->getHeight());
+		for(int i = 0; i < order.size(); i++) {
+			order[i] = i;
+		}
+		RowSorter sorter(rel, keyCols, pool);
+		sorter.sort(order);
+		arena->stats.tasks += sorter.tasks;
+		arena->stats.stolenTasks += sorter.stolen;
+	}
+
+	bool spillRun() {
+		//sorts rel, writes it to a new run file and empties it
+		string path = newRunPath();
+		runFiles.push_back(path);
+		sortRows();
+		SortRunWriter writer(path);
+		for(int i = 0; i < order.size() && writer.good(); i++) {
+			writer.write(rel, order[i]);
+		}
+		if(!writer.close()) {
+			cerr << "****| ERROR |**| Could not write sort run " << path << " |****" << endl;
+			return false;
+		}
+		vector<int>().swap(order);
+		for(int c = 0; c < rel->columns.size(); c++) {
+			rel->columns[c].clear();
+		}
+		arena->stats.sortRuns++;
+		return true;
+	}
+
+	string newRunPath() {
+		static int runsWritten = 0;
+		return tempDir + "sortrun" + intToString(processId()) + "_" + intToString(runsWritten++) + ".tmp";
+	}
+
+	bool startMerge() {
+		//with more runs than files it should keep open at once, the oldest SORT_MERGE_FAN_IN
+		//are merged into one run first, which takes their place, until few enough are left
+		while(runFiles.size() > SORT_MERGE_FAN_IN) {
+			string path = newRunPath();
+			openReaders(SORT_MERGE_FAN_IN);
+			SortRunWriter writer(path);
+			while(!heap.empty()) {
+				writer.write(readers[smallestRun()]->tuple);
+				nextOfRun();
+			}
+			bool written = writer.close();
+			removeRuns(SORT_MERGE_FAN_IN);
+			arena->refund((long)SORT_MERGE_FAN_IN * SORT_RUN_BUFFER);
+			runFiles.insert(runFiles.begin(), path);
+			if(!written) {
+				cerr << "****| ERROR |**| Could not write sort run " << path << " |****" << endl;
+				return false;
+			}
+		}
+		out = withSchema(arena->newRelation("order"), this);
+		openReaders(runFiles.size());
+		return true;
+	}
+
+	void openReaders(int runs) {
+		//readers of the first runs run files, and the heap of their first tuples
+		for(int r = 0; r < runs; r++) {
+			readers.push_back(new SortRunReader(runFiles[r], names.size()));
+			arena->charge(SORT_RUN_BUFFER);
+			if(readers[r]->next()) {
+				heap.push_back(r);
+				push_heap(heap.begin(), heap.end(), LaterRun(this));
+			}
+		}
+	}
+
+	int smallestRun() {
+		//the run whose current tuple comes next
+		return heap.front();
+	}
+
+	void nextOfRun() {
+		//the smallest run moves on to its next tuple
+		pop_heap(heap.begin(), heap.end(), LaterRun(this));
+		if(readers[heap.back()]->next()) {
+			push_heap(heap.begin(), heap.end(), LaterRun(this));
+		} else {
+			heap.pop_back();
+		}
+	}
+
+	int compareRuns(int a, int b) {
+		//<0, 0 or >0 as run a's current tuple sorts before, with or after run b's
+		for(int k = 0; k < keyCols.size(); k++) {
+			int cmp = compareCells(readers[a]->tuple[keyCols[k]], readers[b]->tuple[keyCols[k]], types[keyCols[k]].isInt());
+			if(cmp != 0) {
+				return cmp;
+			}
+		}
+		return a - b;
+	}
+
+	class LaterRun{
+	//heap order, see compareRuns
+	public:
+		LaterRun(OrderOp* Op) {
+			op = Op;
+		}
+		bool operator()(int a, int b) const {
+			return op->compareRuns(a, b) > 0;
+		}
+	private:
+		OrderOp* op;
+	};
+
+	bool nextMergedBatch(Batch& batch) {
+		clearOut(out, outBytes);
+		for(int count = 0; count < BATCH_SIZE && !heap.empty(); count++) {
+			vector<string>& tuple = readers[smallestRun()]->tuple;
+			for(int c = 0; c < tuple.size(); c++) {
+				out->columns[c].addCell(tuple[c]);
+				outBytes += cellBytes(tuple[c]);
+			}
+			nextOfRun();
+		}
+		arena->charge(outBytes);
+		return outBatch(out, batch);
+	}
+
+	void removeRuns(int runs = -1) {
+		//closes the readers and removes the first runs run files, all of them by default
+		for(int r = 0; r < readers.size(); r++) {
+			delete readers[r];
+		}
+		readers.clear();
+		heap.clear();
+		if(runs == -1) {
+			runs = runFiles.size();
+		}
+		for(int r = 0; r < runs; r++) {
+			remove(runFiles[r].c_str());
+		}
+		runFiles.erase(runFiles.begin(), runFiles.begin() + runs);
+	}
+};
+
+class LimitOp : public Operator{
+//limit ( n ) expr: the first n tuples, after which nothing more is pulled from the input, so
+//a scan under it stops reading
+public:
+	LimitOp(Operator* Child, int Count) {
+		child = Child;
+		count = Count;
+		names = child->names;
+		types = child->types;
+	}
+
+	~LimitOp() {
+		delete child;
+	}
+
+	bool open() {
+		left = count;
+		return child->open();
+	}
+
+	bool nextBatch(Batch& batch) {
+		if(left <= 0 || !child->nextBatch(batch)) {
+			return false;
+		}
+		if(batch.size() > left) {
+			batch.rows.resize(left);
+		}
+		left -= batch.size();
+		return true;
+	}
+
+	vector<string> sortedBy() {
+		return child->sortedBy();
+	}
+
+	void close() {
+		child->close();
+	}
+
+private:
+	Operator* child;
+	int count;
+	int left;	//tuples still to return
+};
+
+class TopNOp : public Operator{
+//limit ( n ) ( order ( attribute-list ) expr ): the first n tuples of the ordering, found in
+//one pass over the input with a heap of the n first tuples so far, the last of them on top.
+//Only tuples that come before the top are copied, instead of the whole input being sorted.
+//Among equal tuples the earlier one comes first, as with OrderOp.
+public:
+	TopNOp(Operator* Child, vector<string> Attrs, int Count) {
+		child = Child;
+		attrs = Attrs;
+		count = Count;
+		rel = 0;
+		names = child->names;
+		types = child->types;
+	}
+
+	~TopNOp() {
+		delete child;
+	}
+
+	bool open() {
+		keyCols.clear();
+		for(int i = 0; i < attrs.size(); i++) {
+			keyCols.push_back(requireColumn(attrs[i]));
+			if(keyCols.back() < 0) {
+				return false;
+			}
+		}
+		if(!child->open()) {
+			return false;
+		}
+		heap.clear();
+		long seq = 0;
+		Batch batch;
+		while(count > 0 && child->nextBatch(batch)) {
+			for(int i = 0; i < batch.size(); i++, seq++) {
+				if(heap.size() == count && compareToTop(batch, i) >= 0) {
+					continue;
+				}
+				if(heap.size() == count) {
+					pop_heap(heap.begin(), heap.end(), EarlierTuple(this));
+					heap.pop_back();
+				}
+				heap.push_back(Entry());
+				heap.back().seq = seq;
+				heap.back().tuple = batch.getTuple(i);
+				push_heap(heap.begin(), heap.end(), EarlierTuple(this));
+			}
+		}
+		sort_heap(heap.begin(), heap.end(), EarlierTuple(this));
+		rel = withSchema(arena->newRelation("topN"), this);
+		for(int i = 0; i < heap.size(); i++) {
+			for(int c = 0; c < heap[i].tuple.size(); c++) {
+				rel->columns[c].addCell(heap[i].tuple[c]);
+				arena->charge(cellBytes(heap[i].tuple[c]));
+			}
+		}
+		heap.clear();
+		pos = 0;
+		return true;
+	}
+
+	bool nextBatch(Batch& batch) {
+		return sliceBatch(rel, pos, batch);
+	}
+
+	vector<string> sortedBy() {
+		return attrs;
+	}
+
+	void close() {
+		//rel belongs to the arena
+		child->close();
+	}
+
+private:
+	struct Entry{
+		vector<string> tuple;
+		long seq;	//position in the input
+	};
+
+	class EarlierTuple{
+	public:
+		EarlierTuple(TopNOp* Op) {
+			op = Op;
+		}
+		bool operator()(const Entry& a, const Entry& b) const {
+			int cmp = op->compareEntries(a, b);
+			return (cmp != 0 ? cmp < 0 : a.seq < b.seq);
+		}
+	private:
+		TopNOp* op;
+	};
+
+	Operator* child;
+	vector<string> attrs;	//sort keys, most significant first
+	vector<int> keyCols;
+	int count;
+	vector<Entry> heap;
+	Relation* rel;			//the first count tuples, in order
+	int pos;				//next of them to return
+
+	int compareEntries(const Entry& a, const Entry& b) {
+		for(int k = 0; k < keyCols.size(); k++) {
+			int cmp = compareCells(a.tuple[keyCols[k]], b.tuple[keyCols[k]], types[keyCols[k]].isInt());
+			if(cmp != 0) {
+				return cmp;
+			}
+		}
+		return 0;
+	}
+
+	int compareToTop(Batch& batch, int i) {
+		//<0 if tuple i of batch comes before the heap's last tuple. Equal keys don't: the top is earlier
+		for(int k = 0; k < keyCols.size(); k++) {
+			int cmp = compareCells(batch.get(keyCols[k], i), heap.front().tuple[keyCols[k]], types[keyCols[k]].isInt());
+			if(cmp != 0) {
+				return cmp;
+			}
+		}
+		return 0;
+	}
+};
+
+class HashAggregateOp : public Operator{
+//group ( attribute-list ) aggregate ( aggregate-list ) expr: one tuple per group of equal group
+//attributes, those attributes then every aggregate over the group's tuples. The attributes
+//they read are copied out of the input (see GroupSpec) and cut into one range of rows per
+//thread of the pool. A task per range aggregates it into a GroupTable of its own (see
+//Aggregation.h), then the tables are merged. Groups come out in order of their first tuple.
+//count, sum and avg give INTEGERs (avg truncated), min and max the type of their attribute;
+//sum and avg of a VARCHAR attribute can't run.
+public:
+	HashAggregateOp(Operator* Child, vector<string> Attrs, vector<AggregateCall> Aggs, TaskPool* Pool) {
+		child = Child;
+		attrs = Attrs;
+		aggs = Aggs;
+		pool = Pool;
+		rel = 0;
+		for(int i = 0; i < attrs.size(); i++) {
+			int pos = child->findColumn(attrs[i]);
+			names.push_back(attrs[i]);
+			types.push_back(pos >= 0 ? child->types[pos] : DataType(false));
+		}
+		for(int a = 0; a < aggs.size(); a++) {
+			int pos = (aggs[a].attr == "" ? -1 : child->findColumn(aggs[a].attr));
+			bool keepsType = (aggs[a].function == MinAgg || aggs[a].function == MaxAgg);
+			names.push_back(aggs[a].name());
+			types.push_back(keepsType && pos >= 0 ? child->types[pos] : DataType(true));
+		}
+	}
+
+	~HashAggregateOp() {
+		delete child;
+	}
+
+	bool open() {
+		spec = GroupSpec();
+		spec.rel = arena->newRelation("groupInput");
+		inputCols.clear();
+		for(int i = 0; i < attrs.size(); i++) {
+			int col = child->requireColumn(attrs[i]);
+			if(col < 0) {
+				return false;
+			}
+			spec.keyCols.push_back(inputColumn(col));
+		}
+		for(int a = 0; a < aggs.size(); a++) {
+			int col = -1;
+			if(aggs[a].attr != "") {
+				col = child->requireColumn(aggs[a].attr);
+				if(col < 0) {
+					return false;
+				}
+			} else if(aggs[a].function != CountAgg) {
+				//only count ( * ) goes without an attribute
+				cerr << "****| ERROR |**| " << aggregateSpellings[aggs[a].function] << " needs an attribute |****" << endl;
+				return false;
+			}
+			if((aggs[a].function == SumAgg || aggs[a].function == AvgAgg) && !child->types[col].isInt()) {
+				cerr << "****| ERROR |**| Cannot " << aggregateSpellings[aggs[a].function] << " VARCHAR attribute " << aggs[a].attr << " |****" << endl;
+				return false;
+			}
+			spec.functions.push_back(aggs[a].function);
+			spec.aggCols.push_back(col < 0 ? -1 : inputColumn(col));
+		}
+		if(!child->open()) {
+			return false;
+		}
+		readInput();
+		GroupTable* groups = aggregate();
+		rel = withSchema(arena->newRelation("group"), this);
+		for(int g = 0; g < groups->size(); g++) {
+			int row = groups->firstRows[g];
+			for(int k = 0; k < spec.keyCols.size(); k++) {
+				string cell = spec.cell(spec.keyCols[k], row);
+				rel->columns[k].addCell(cell);
+				arena->charge(cellBytes(cell));
+			}
+			for(int a = 0; a < aggs.size(); a++) {
+				string cell = groups->result(g, a);
+				rel->columns[spec.keyCols.size() + a].addCell(cell);
+				arena->charge(cellBytes(cell));
+			}
+		}
+		arena->stats.groups += groups->size();
+		arena->refund(groups->bytes());
+		delete groups;
+		vector< vector<int> >().swap(spec.intColumns);
+		pos = 0;
+		return true;
+	}
+
+	bool nextBatch(Batch& batch) {
+		return sliceBatch(rel, pos, batch);
+	}
+
+	vector<string> sortedBy() {
+		//groups come out in the order of their first tuples, so in the child's order up to its
+		//first attribute that isn't a group attribute
+		vector<string> order = child->sortedBy();
+		for(int i = 0; i < order.size(); i++) {
+			if(find(attrs.begin(), attrs.end(), order[i]) == attrs.end()) {
+				order.resize(i);
+			}
+		}
+		return order;
+	}
+
+	void close() {
+		//rel and the input belong to the arena
+		child->close();
+	}
+
+private:
+	Operator* child;
+	vector<string> attrs;		//group attributes
+	vector<AggregateCall> aggs;
+	TaskPool* pool;
+	vector<int> inputCols;		//child columns the aggregation reads
+	GroupSpec spec;				//those columns of the input's tuples
+	Relation* rel;				//a tuple per group
+	int pos;					//next of them to return
+
+	int inputColumn(int col) {
+		//position of the child's column col among inputCols, adding it to them and to spec
+		for(int i = 0; i < inputCols.size(); i++) {
+			if(inputCols[i] == col) {
+				return i;
+			}
+		}
+		inputCols.push_back(col);
+		spec.intCols.push_back(child->types[col].isInt());
+		if(child->types[col].isInt()) {
+			spec.slots.push_back(spec.intColumns.size());
+			spec.intColumns.push_back(vector<int>());
+		} else {
+			spec.slots.push_back(spec.rel->columns.size());
+			spec.rel->addAttribute(child->names[col], child->types[col]);
+		}
+		return inputCols.size() - 1;
+	}
+
+	void readInput() {
+		//the input's inputCols into spec, INTEGERs read as numbers
+		Batch batch;
+		while(child->nextBatch(batch)) {
+			long bytes = 0;
+			for(int i = 0; i < inputCols.size(); i++) {
+				Attribute& column = batch.src->columns[batch.colMap[inputCols[i]]];
+				if(spec.intCols[i]) {
+					vector<int>& ints = spec.intColumns[spec.slots[i]];
+					for(int r = 0; r < batch.size(); r++) {
+						ints.push_back(column.getInt(batch.rows[r]));
+					}
+					bytes += (long)batch.size() * sizeof(int);
+					continue;
+				}
+				Attribute& cells = spec.rel->columns[spec.slots[i]];
+				for(int r = 0; r < batch.size(); r++) {
+					boost::string_ref cell = column.getView(batch.rows[r]);
+					cells.addCell(cell);
+					bytes += cellBytes(cell);
+				}
+			}
+			arena->charge(bytes);
+		}
+	}
+
+	GroupTable* aggregate() {
+		//the groups of all the input's rows, the caller deletes them
+		int height = spec.height();
+		int ranges = max(1, min(pool->threads(), (height + MORSEL_ROWS - 1) / MORSEL_ROWS));
+		vector<int> starts;
+		for(int r = 0; r <= ranges; r++) {
+			starts.push_back((long)height * r / ranges);
+		}
+		vector<GroupTable*> partials;	//one per range of rows
+		for(int r = 0; r < ranges; r++) {
+			partials.push_back(new GroupTable(&spec));
+		}
+		TaskGroup group;
+		for(int r = 0; r < ranges; r++) {
+			pool->submit(group, boost::bind(&GroupTable::addRows, partials[r], starts[r], starts[r + 1]));
+		}
+		pool->wait(group);
+		arena->stats.tasks += group.tasks;
+		arena->stats.stolenTasks += group.stolen;
+		long partialBytes = 0;
+		for(int r = 0; r < ranges; r++) {
+			partialBytes += partials[r]->bytes();
+		}
+		arena->charge(partialBytes);
+		GroupTable* groups = partials[0];
+		for(int r = 1; r < ranges; r++) {
+			groups->merge(*partials[r]);
+			delete partials[r];
+		}
+		arena->charge(groups->bytes());
+		arena->refund(partialBytes);
+		return groups;
+	}
+};
+
+vector<int> matchColumns(Operator* left, Operator* right) {
+	//position in right of each of left's columns: by name if right has them all,
+	//otherwise by position. Empty if the two are not union compatible.
+	vector<int> positions;
+	if(left->names.size() != right->names.size()) {
+		return positions;
+	}
+	for(int i = 0; i < left->names.size(); i++) {
+		int pos = right->findColumn(left->names[i]);
+		if(pos < 0) {
+			positions.clear();
+			break;
+		}
+		positions.push_back(pos);
+	}
+	if(positions.empty()) {
+		for(int i = 0; i < left->names.size(); i++) {
+			positions.push_back(i);
+		}
+	}
+	return positions;
+}
+
+class UnionOp : public Operator{
+//Streams left then right, dropping tuples already seen.
+public:
+	UnionOp(Operator* Left, Operator* Right) {
+		left = Left;
+		right = Right;
+		names = left->names;
+		types = left->types;
+	}
+
+	~UnionOp() {
+		delete left;
+		delete right;
+	}
+
+	bool open() {
+		positions = matchColumns(left, right);
+		onRight = false;
+		seen.clear();
+		return positions.size() == names.size() && names.size() > 0 && left->open() && right->open();
+	}
+
+	bool nextBatch(Batch& batch) {
+		while(true) {
+			if(!onRight) {
+				if(!left->nextBatch(batch)) {
+					onRight = true;
+					continue;
+				}
+			} else {
+				if(!right->nextBatch(batch)) {
+					return false;
+				}
+				vector<int> colMap;
+				for(int i = 0; i < positions.size(); i++) {
+					colMap.push_back(batch.colMap[positions[i]]);
+				}
+				batch.colMap = colMap;
+			}
+			dropSeen(batch);
+			if(batch.size() > 0) {
+				return true;
+			}
+		}
+	}
+
+	void close() {
+		seen.clear();
+		left->close();
+		right->close();
+	}
+
+private:
+	Operator* left;
+	Operator* right;
+	vector<int> positions;
+	bool onRight;
+	set<string> seen;
+
+	void dropSeen(Batch& batch) {
+		vector<int> rows;
+		for(int i = 0; i < batch.size(); i++) {
+			string key = batch.tupleKey(i);
+			if(seen.insert(key).second) {
+				rows.push_back(batch.rows[i]);
+				arena->charge(cellBytes(key));
+			}
+		}
+		batch.rows = rows;
+	}
+};
+
+class DifferenceOp : public Operator{
+//Reads right once into a set of tuples, then streams the left tuples not in it.
+public:
+	DifferenceOp(Operator* Left, Operator* Right) {
+		left = Left;
+		right = Right;
+		names = left->names;
+		types = left->types;
+	}
+
+	~DifferenceOp() {
+		delete left;
+		delete right;
+	}
+
+	bool open() {
+		vector<int> positions = matchColumns(left, right);
+		if(positions.size() != names.size() || names.size() == 0 || !left->open() || !right->open()) {
+			return false;
+		}
+		exclude.clear();
+		Batch batch;
+		while(right->nextBatch(batch)) {
+			vector<int> colMap;
+			for(int i = 0; i < positions.size(); i++) {
+				colMap.push_back(batch.colMap[positions[i]]);
+			}
+			batch.colMap = colMap;
+			for(int i = 0; i < batch.size(); i++) {
+				string key = batch.tupleKey(i);
+				if(exclude.insert(key).second) {
+					arena->charge(cellBytes(key));
+				}
+			}
+		}
+		return true;
+	}
+
+	bool nextBatch(Batch& batch) {
+		while(left->nextBatch(batch)) {
+			vector<int> rows;
+			for(int i = 0; i < batch.size(); i++) {
+				//inserting into exclude also drops duplicates within left
+				string key = batch.tupleKey(i);
+				if(exclude.insert(key).second) {
+					rows.push_back(batch.rows[i]);
+					arena->charge(cellBytes(key));
+				}
+			}
+			batch.rows = rows;
+			if(batch.size() > 0) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void close() {
+		exclude.clear();
+		left->close();
+		right->close();
+	}
+
+private:
+	Operator* left;
+	Operator* right;
+	set<string> exclude;
+};
+
+#endif
@@ -0,0 +1,168 @@
+#ifndef PACKEDINTS_H
+#define PACKEDINTS_H
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <boost/cstdint.hpp>
+#include <boost/utility/string_ref.hpp>
+
+using namespace std;
+
+//Compressed INTEGER column storage (see Attribute::chooseEncoding).
+//	BitPackedInts: frame of reference + bitpacking, every value stored as (value - base)
+//		in just enough bits for the column's range
+//	RunLengthInts: (value, run end) pairs, for sorted or otherwise repetitive columns
+
+bool canonicalInt(boost::string_ref cell, int& value) {
+	//true if cell is exactly how intToString would print some int, so packing it loses nothing
+	if(cell.size() == 0 || cell.size() > 11) {
+		return false;
+	}
+	int i = (cell[0] == '-' ? 1 : 0);
+	if(i == cell.size() || (cell[i] == '0' && (cell.size() > i + 1 || i == 1))) {
+		return false; //"-", leading zeros, "-0"
+	}
+	long long v = 0;
+	for(; i < cell.size(); i++) {
+		if(cell[i] < '0' || cell[i] > '9') {
+			return false;
+		}
+		v = v * 10 + (cell[i] - '0');
+	}
+	if(cell[0] == '-') {
+		v = -v;
+	}
+	if(v < -2147483647LL - 1 || v > 2147483647LL) {
+		return false;
+	}
+	value = (int)v;
+	return true;
+}
+
+class BitPackedInts{
+public:
+	int base;
+	int bits;	//0..32
+	int count;
+	vector<boost::uint64_t> words;
+
+	BitPackedInts() {
+		base = 0;
+		bits = 0;
+		count = 0;
+	}
+
+	void pack(const vector<int>& values) {
+		clear();
+		if(values.empty()) {
+			return;
+		}
+		int minV = *min_element(values.begin(), values.end());
+		int maxV = *max_element(values.begin(), values.end());
+		base = minV;
+		boost::uint64_t range = (boost::uint64_t)((long long)maxV - minV);
+		while(bits < 32 && (range >> bits) != 0) {
+			bits++;
+		}
+		words.reserve(((long long)values.size() * bits + 63) / 64);
+		for(int i = 0; i < values.size(); i++) {
+			push_back(values[i]);
+		}
+	}
+
+	bool fits(int value) {
+		long long offset = (long long)value - base;
+		return offset >= 0 && (bits == 32 || offset < (1LL << bits));
+	}
+
+	boost::uint64_t code(int i) {
+		//value i - base, without unpacking anything else
+		if(bits == 0) {
+			return 0;
+		}
+		long long bitPos = (long long)i * bits;
+		int word = bitPos >> 6;
+		int offset = bitPos & 63;
+		boost::uint64_t v = words[word] >> offset;
+		if(offset + bits > 64) {
+			v |= words[word + 1] << (64 - offset);
+		}
+		return v & mask();
+	}
+
+	int get(int i) {
+		return (int)(base + (long long)code(i));
+	}
+
+	void set(int i, int value) {
+		//value must fit
+		if(bits == 0) {
+			return;
+		}
+		boost::uint64_t v = (boost::uint64_t)((long long)value - base);
+		long long bitPos = (long long)i * bits;
+		int word = bitPos >> 6;
+		int offset = bitPos & 63;
+		words[word] = (words[word] & ~(mask() << offset)) | (v << offset);
+		if(offset + bits > 64) {
+			int high = 64 - offset;
+			words[word + 1] = (words[word + 1] & ~(mask() >> high)) | (v >> high);
+		}
+	}
+
+	void push_back(int value) {
+		//value must fit
+		count++;
+		while(words.size() * 64 < (long long)count * bits) {
+			words.push_back(0);
+		}
+		set(count - 1, value);
+	}
+
+	void clear() {
+		bits = 0;
+		count = 0;
+		words.clear();
+	}
+
+private:
+	boost::uint64_t mask() {
+		return (bits == 64 ? ~(boost::uint64_t)0 : (((boost::uint64_t)1 << bits) - 1));
+	}
+};
+
+class RunLengthInts{
+public:
+	vector<int> values;	//value of each run
+	vector<int> ends;	//one past the last row of each run
+
+	int size() {
+		return (ends.empty() ? 0 : ends.back());
+	}
+
+	int run(int i) {
+		//run holding row i
+		return upper_bound(ends.begin(), ends.end(), i) - ends.begin();
+	}
+
+	int get(int i) {
+		return values[run(i)];
+	}
+
+	void push_back(int value) {
+		if(!values.empty() && values.back() == value) {
+			ends.back()++;
+		} else {
+			values.push_back(value);
+			ends.push_back(size() + 1);
+		}
+	}
+
+	void clear() {
+		values.clear();
+		ends.clear();
+	}
+};
+
+#endif
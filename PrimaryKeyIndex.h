@@ -0,0 +1,102 @@
+#ifndef PRIMARYKEYINDEX_H
+#define PRIMARYKEYINDEX_H
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <boost/unordered_map.hpp>
+#include "Attribute.h"
+
+using namespace std;
+
+//Primary key index: a hash table from the primary key values of each row to the row, for
+//selections that give every primary key attribute a value (userId == 7). Made for every
+//relation with a PRIMARY KEY, and kept in the relation's .idx file with its other indexes.
+//Duplicate keys aren't rejected, so a key can still map to several rows.
+
+const char PRIMARY_KEY_SEPARATOR = '\x1f'; //between the values of a composite key
+
+class PrimaryKeyIndex{
+public:
+	vector<int> attrIds;	//symbol ids of the primary key attributes, in key order
+	vector<bool> isInt;
+	boost::unordered_multimap<string, int> rows;	//key -> rows holding it
+	int indexedRows;		//rows 0..indexedRows-1 are in the table
+	vector<int> builtChanges;	//changes count of each key column the table is up to date with
+
+	PrimaryKeyIndex(vector<Attribute*> columns) {
+		for(int i = 0; i < columns.size(); i++) {
+			attrIds.push_back(columns[i]->nameId);
+			isInt.push_back(columns[i]->isInt());
+			builtChanges.push_back(columns[i]->changes);
+		}
+		indexedRows = 0;
+	}
+
+	void refresh(vector<Attribute*> columns) {
+		//catches up with the key columns: appended rows are added, any other change rebuilds the table
+		bool rebuild = false;
+		for(int i = 0; i < columns.size(); i++) {
+			rebuild = rebuild || columns[i]->changes != builtChanges[i] || indexedRows > columns[i]->getSize();
+		}
+		if(rebuild) {
+			rows.clear();
+			indexedRows = 0;
+			for(int i = 0; i < columns.size(); i++) {
+				builtChanges[i] = columns[i]->changes;
+			}
+		}
+		int height = columns[0]->getSize();
+		for(; indexedRows < height; indexedRows++) {
+			string key;
+			for(int i = 0; i < columns.size(); i++) {
+				if(isInt[i]) {
+					key += intToString(columns[i]->getInt(indexedRows)); //"007" is found as 7, like == finds it
+				} else {
+					key += columns[i]->getElement(indexedRows);
+				}
+				key += PRIMARY_KEY_SEPARATOR;
+			}
+			rows.insert(make_pair(key, indexedRows));
+		}
+	}
+
+	string key(vector<string>& values) {
+		//key of a row holding values, one per primary key attribute
+		string out;
+		for(int i = 0; i < values.size(); i++) {
+			out += (isInt[i] ? intToString(leadingInt(values[i])) : values[i]);
+			out += PRIMARY_KEY_SEPARATOR;
+		}
+		return out;
+	}
+
+	void add(const string& key, int row) {
+		rows.insert(make_pair(key, row));
+		indexedRows = max(indexedRows, row + 1);
+	}
+
+	void lookup(const string& key, vector<int>& found) {
+		//rows holding key, in row order
+		pair<boost::unordered_multimap<string, int>::iterator, boost::unordered_multimap<string, int>::iterator> range = rows.equal_range(key);
+		for(; range.first != range.second; ++range.first) {
+			found.push_back(range.first->second);
+		}
+		sort(found.begin(), found.end());
+	}
+
+	string stringify() {
+		//"PRIMARY <entries> <attribute>...", then "row key" per entry
+		string out = "PRIMARY " + intToString(rows.size());
+		for(int i = 0; i < attrIds.size(); i++) {
+			out += " " + symbols().name(attrIds[i]);
+		}
+		out += "\n";
+		for(boost::unordered_multimap<string, int>::iterator it = rows.begin(); it != rows.end(); ++it) {
+			out += intToString(it->second) + " " + it->first + "\n";
+		}
+		return out;
+	}
+};
+
+#endif
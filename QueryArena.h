@@ -0,0 +1,101 @@
+#ifndef QUERYARENA_H
+#define QUERYARENA_H
+
+#include <string>
+#include <vector>
+#include "Relation.h"
+
+using namespace std;
+
+//Per-query allocation scope. Every intermediate Relation an operator needs (e.g. the
+//inner side of a product) is allocated from the running query's arena and freed when
+//the query completes, instead of living until the DBMS shuts down.
+
+long cellBytes(boost::string_ref cell) {
+	//approximate heap footprint of one cell
+	return sizeof(string) + cell.size();
+}
+
+class QueryStats{
+public:
+	long peakBytes;		//high-water mark of intermediate and result cells
+	int prunedBlocks;	//blocks of ZONE_ROWS rows scans skipped thanks to zone maps
+	int indexScans;		//scans that only read the rows a B+tree, bitmap or cracker index found
+	int cracks;			//pieces of cracker indexes partitioned by selections
+	int tasks;			//tasks the query ran on the DBMS's TaskPool
+	int stolenTasks;	//of those, tasks stolen by another thread than the one that queued them
+	int joinPartitions;	//partitions hash joins split their inputs into
+	int mergeJoins;		//joins run as merge joins, their inputs being in order already
+	int sortRuns;		//sorted runs orderings wrote to temporary files, being over the sort memory
+	int groups;			//groups hash aggregations found
+
+	QueryStats() {
+		peakBytes = 0;
+		prunedBlocks = 0;
+		indexScans = 0;
+		cracks = 0;
+		tasks = 0;
+		stolenTasks = 0;
+		joinPartitions = 0;
+		mergeJoins = 0;
+		sortRuns = 0;
+		groups = 0;
+	}
+
+	void print() {
+		cout << "query peak memory: " << peakBytes << " bytes\n";
+		cout << "query pruned blocks: " << prunedBlocks << "\n";
+		cout << "query index scans: " << indexScans << "\n";
+		cout << "query cracks: " << cracks << "\n";
+		cout << "query tasks: " << tasks << " (" << stolenTasks << " stolen)\n";
+		cout << "query join partitions: " << joinPartitions << "\n";
+		cout << "query merge joins: " << mergeJoins << "\n";
+		cout << "query sort runs: " << sortRuns << "\n";
+		cout << "query groups: " << groups << "\n";
+	}
+};
+
+class QueryArena{
+public:
+	QueryStats stats;
+	long curBytes;
+
+	QueryArena() {
+		curBytes = 0;
+	}
+
+	~QueryArena() {
+		release();
+	}
+
+	Relation* newRelation(string name) {
+		Relation* rel = new Relation(name);
+		rels.push_back(rel);
+		return rel;
+	}
+
+	void charge(long bytes) {
+		curBytes += bytes;
+		if(curBytes > stats.peakBytes) {
+			stats.peakBytes = curBytes;
+		}
+	}
+
+	void refund(long bytes) {
+		curBytes -= bytes;
+	}
+
+	void release() {
+		//frees everything allocated by the query
+		for(int i = 0; i < rels.size(); i++) {
+			delete rels[i];
+		}
+		rels.clear();
+		curBytes = 0;
+	}
+
+private:
+	vector<Relation*> rels;
+};
+
+#endif
@@ -0,0 +1,211 @@
+#ifndef QUERYPLAN_H
+#define QUERYPLAN_H
+
+#include <string>
+#include <vector>
+#include <set>
+#include <boost/shared_ptr.hpp>
+#include "CondConjCompOp.h"
+#include "Helpers.h"
+#include "Aggregation.h"
+
+using namespace std;
+
+//A query plan is a tree of relational operators. The ParserEngine builds one out of
+//the scanner tokens, the in-process query builder (DBMS::from) builds one directly,
+//and both are handed to the same ExecEngine to run.
+
+enum PlanType { ScanPlan=0, SelectPlan, ProjectPlan, RenamePlan, ProductPlan, UnionPlan, DifferencePlan, JoinPlan, OrderPlan, LimitPlan, GroupPlan };
+
+class PlanNode;
+typedef boost::shared_ptr<PlanNode> PlanPtr;
+
+class PlanNode{
+public:
+	PlanType type;
+	string relName;				//ScanPlan: relation to read from relsInMem
+	int relId;					//ScanPlan: symbol id of relName
+	Condition cond;				//SelectPlan: tuples must pass this
+	vector<string> attrs;		//ProjectPlan: attributes to keep, RenamePlan: new attribute names, JoinPlan: left and right join attribute, OrderPlan: sort keys, GroupPlan: group attributes
+	vector<AggregateCall> aggs;	//GroupPlan: aggregates of every group
+	int count;					//LimitPlan: tuples to keep
+	vector<PlanPtr> children;	//inputs, in grammar order
+	bool scanAll;				//ScanPlan: every column is needed (set by ExecEngine::requireColumns)
+	set<string> scanCols;		//ScanPlan: otherwise, the columns the query reads
+
+	PlanNode(PlanType Type) {
+		type = Type;
+		relId = NO_SYMBOL;
+		count = 0;
+		scanAll = true;
+	}
+};
+
+PlanPtr makeScanPlan(string relName) {
+	PlanPtr plan(new PlanNode(ScanPlan));
+	plan->relName = relName;
+	plan->relId = symbols().intern(relName);
+	return plan;
+}
+
+PlanPtr makeSelectPlan(Condition cond, PlanPtr input) {
+	PlanPtr plan(new PlanNode(SelectPlan));
+	plan->cond = cond;
+	plan->children.push_back(input);
+	return plan;
+}
+
+PlanPtr makeProjectPlan(vector<string> attrs, PlanPtr input) {
+	PlanPtr plan(new PlanNode(ProjectPlan));
+	plan->attrs = attrs;
+	plan->children.push_back(input);
+	return plan;
+}
+
+PlanPtr makeRenamePlan(vector<string> attrs, PlanPtr input) {
+	PlanPtr plan(new PlanNode(RenamePlan));
+	plan->attrs = attrs;
+	plan->children.push_back(input);
+	return plan;
+}
+
+PlanPtr makeOrderPlan(vector<string> attrs, PlanPtr input) {
+	PlanPtr plan(new PlanNode(OrderPlan));
+	plan->attrs = attrs;
+	plan->children.push_back(input);
+	return plan;
+}
+
+PlanPtr makeLimitPlan(int count, PlanPtr input) {
+	PlanPtr plan(new PlanNode(LimitPlan));
+	plan->count = count;
+	plan->children.push_back(input);
+	return plan;
+}
+
+PlanPtr makeGroupPlan(vector<string> attrs, vector<AggregateCall> aggs, PlanPtr input) {
+	PlanPtr plan(new PlanNode(GroupPlan));
+	plan->attrs = attrs;
+	plan->aggs = aggs;
+	plan->children.push_back(input);
+	return plan;
+}
+
+PlanPtr makeBinaryPlan(PlanType type, PlanPtr left, PlanPtr right) {
+	//product, union and difference
+	PlanPtr plan(new PlanNode(type));
+	plan->children.push_back(left);
+	plan->children.push_back(right);
+	return plan;
+}
+
+PlanPtr makeJoinPlan(PlanPtr left, PlanPtr right, string leftAttr, string rightAttr) {
+	//tuples of left * right whose leftAttr == rightAttr
+	PlanPtr plan = makeBinaryPlan(JoinPlan, left, right);
+	plan->attrs.push_back(leftAttr);
+	plan->attrs.push_back(rightAttr);
+	return plan;
+}
+
+
+//Query builder predicates. These build the same Condition trees getCondition() does, so
+//	col("homeruns") >= 40 && col("team") == "Pirates"
+//is equivalent to the text condition (homeruns >= 40 && team == "Pirates")
+class ColumnRef{
+public:
+	string name;
+	ColumnRef(string Name) {
+		name = Name;
+	}
+};
+
+ColumnRef col(string name) {
+	return ColumnRef(name);
+}
+
+Condition makeCondition(Operand left, Operation op, Operand right) {
+	Comparison comp;
+	comp.isCondition = false;
+	comp.operand1 = left;
+	comp.op = op;
+	comp.operand2 = right;
+	Conjunction conj;
+	conj.comparisons.push_back(comp);
+	Condition cond;
+	cond.conjunctions.push_back(conj);
+	return cond;
+}
+
+Condition makeCondition(ColumnRef left, Operation op, string literal) {
+	Operand attr;
+	attr.isAttribute = true;
+	attr.val = left.name;
+	attr.nameId = symbols().intern(left.name);
+	Operand lit;
+	lit.isAttribute = false;
+	lit.val = literal;
+	return makeCondition(attr, op, lit);
+}
+
+Condition makeCondition(ColumnRef left, Operation op, ColumnRef right) {
+	Operand attr1;
+	attr1.isAttribute = true;
+	attr1.val = left.name;
+	attr1.nameId = symbols().intern(left.name);
+	Operand attr2;
+	attr2.isAttribute = true;
+	attr2.val = right.name;
+	attr2.nameId = symbols().intern(right.name);
+	return makeCondition(attr1, op, attr2);
+}
+
+Condition operator==(ColumnRef c, string v) { return makeCondition(c, Equality, v); }
+Condition operator!=(ColumnRef c, string v) { return makeCondition(c, NonEquality, v); }
+Condition operator<=(ColumnRef c, string v) { return makeCondition(c, LessThanEqual, v); }
+Condition operator>=(ColumnRef c, string v) { return makeCondition(c, GreaterThanEqual, v); }
+Condition operator<(ColumnRef c, string v) { return makeCondition(c, LessThan, v); }
+Condition operator>(ColumnRef c, string v) { return makeCondition(c, GreaterThan, v); }
+
+//col("title") ^= "Star": title starts with "Star". Being an assignment operator it binds
+//looser than && and ||, so parenthesize it when combining: (col("title") ^= "Star") && ...
+Condition operator^=(ColumnRef c, string v) { return makeCondition(c, Prefix, v); }
+
+Condition operator==(ColumnRef c, int v) { return makeCondition(c, Equality, intToString(v)); }
+Condition operator!=(ColumnRef c, int v) { return makeCondition(c, NonEquality, intToString(v)); }
+Condition operator<=(ColumnRef c, int v) { return makeCondition(c, LessThanEqual, intToString(v)); }
+Condition operator>=(ColumnRef c, int v) { return makeCondition(c, GreaterThanEqual, intToString(v)); }
+Condition operator<(ColumnRef c, int v) { return makeCondition(c, LessThan, intToString(v)); }
+Condition operator>(ColumnRef c, int v) { return makeCondition(c, GreaterThan, intToString(v)); }
+
+Condition operator==(ColumnRef c, ColumnRef v) { return makeCondition(c, Equality, v); }
+Condition operator!=(ColumnRef c, ColumnRef v) { return makeCondition(c, NonEquality, v); }
+Condition operator<=(ColumnRef c, ColumnRef v) { return makeCondition(c, LessThanEqual, v); }
+Condition operator>=(ColumnRef c, ColumnRef v) { return makeCondition(c, GreaterThanEqual, v); }
+Condition operator<(ColumnRef c, ColumnRef v) { return makeCondition(c, LessThan, v); }
+Condition operator>(ColumnRef c, ColumnRef v) { return makeCondition(c, GreaterThan, v); }
+
+Condition operator&&(Condition left, Condition right) {
+	//conjunction of two nested conditions: ( left ) && ( right )
+	Comparison lComp;
+	lComp.isCondition = true;
+	lComp.cond = left;
+	Comparison rComp;
+	rComp.isCondition = true;
+	rComp.cond = right;
+	Conjunction conj;
+	conj.comparisons.push_back(lComp);
+	conj.comparisons.push_back(rComp);
+	Condition cond;
+	cond.conjunctions.push_back(conj);
+	return cond;
+}
+
+Condition operator||(Condition left, Condition right) {
+	Condition cond = left;
+	for(int i = 0; i < right.conjunctions.size(); i++) {
+		cond.conjunctions.push_back(right.conjunctions[i]);
+	}
+	return cond;
+}
+
+#endif
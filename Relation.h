@@ -4,6 +4,12 @@
 #include <string>
 #include <iomanip>
 #include "Attribute.h"
+#include "SecondaryIndex.h"
+#include "BitmapIndex.h"
+#include "CrackerIndex.h"
+#include "PrimaryKeyIndex.h"
+#include "Helpers.h"
+#include "TaskPool.h"
 
 using namespace std;
 
@@ -17,18 +23,41 @@ class Relation {
 public:
 
 	string name;
+	int nameId; //symbol id of name
 	vector<string> primaryKeys; //attribute names
 	//vector<string> values;
 	vector<Attribute> columns;
-	map<string, int> indices;
+	map<int, int> indices; //attribute symbol id -> column
 	//map<string, Attribute>::iterator start;
 	int primaryKey;
+	string sourceFile; //file the relation was read from, "" if created in memory
+	vector<long> columnOffsets; //columnar files: where each column's cells start in sourceFile (empty for row files)
+	int fileHeight; //columnar files: number of tuples in sourceFile
+	vector<char> sectionKinds; //columnar files: how each column is stored, the directory flag ('D', 'F', 'R') or 0 for plain
+	unsigned int fileChecksum; //columnar files: checksum of the cell sections (0 if the file has none), see stringifyColumns
+	vector<PrimaryKeyIndex> primaryIndex; //at most one, see findPrimaryIndex. Indexes are kept in <name>.idx next to the relation's file
+	vector<SecondaryIndex> secondaryIndexes; //CREATE INDEX
+	vector<BitmapIndex> bitmapIndexes; //CREATE BITMAP INDEX
+	vector<CrackerIndex> crackers; //SET CRACKING ON, made by the first selection on a column, never written
+	vector<int> sortedBy; //attribute ids the rows are in ascending order of, most significant first (see sortOrder)
+	long sortedChanges; //changes of all columns when sortedBy was recorded
+	int sortedHeight; //rows when sortedBy was recorded, -1 if it never was
 
 	Relation(string input_name) {
 		name = input_name;
+		nameId = symbols().intern(name);
+		fileHeight = 0;
+		fileChecksum = 0;
+		sortedChanges = 0;
+		sortedHeight = -1;
 	}
 	
 	Relation(string input_name, vector<string> input) {
+		name = input_name;
+		nameId = symbols().intern(name);
+		fileHeight = 0;
+		sortedChanges = 0;
+		sortedHeight = -1;
 		//wip
 	}
 	
@@ -39,12 +68,12 @@ public:
 	void addAttribute(string name, DataType type) {
 		Attribute attr(name, type);
 		columns.push_back(attr);
-		indices[name] = (columns.size() - 1);
+		indices[attr.nameId] = (columns.size() - 1);
 	}
 	
 	void addAttribute(Attribute attrToAdd) {
 		columns.push_back(attrToAdd);
-		indices[attrToAdd.getName()] = (columns.size() - 1);
+		indices[attrToAdd.nameId] = (columns.size() - 1);
 	}
 
 	void addSeveralAttributes(vector<string> name, vector<DataType> type) {
@@ -56,44 +85,157 @@ public:
 	void deleteAttribute(string name) {
 		vector<Attribute>::iterator iter = columns.begin();
 
-		columns.erase((iter + indices[name]));
-		indices.erase(name);
+		int id = symbols().find(name);
+		columns.erase((iter + indices[id]));
+		indices.erase(id);
 	}
 
 	void addTuple(vector<string> input) {
 		int j = 0;
 		for(int i = 0; i < columns.size(); i++) {
-			columns[i].cells.push_back(input[j]);
+			columns[i].addCell(input[j]);
 			j++;
 		}
 	}
 
+	int findOverlongValue(vector<string>& tuple) {
+		//index of the first VARCHAR value longer than its column's declared length, -1 if all fit
+		for(int i = 0; i < columns.size() && i < tuple.size(); i++) {
+			if(!columns[i].fits(tuple[i])) {
+				return i;
+			}
+		}
+		return -1;
+	}
+
 	vector<string> getTuple(int index) {
 		vector<string> output;
 		for(int i = 0; i < columns.size(); i++) {
-			output.push_back(columns[i].cells[index]);
+			output.push_back(columns[i].getElement(index));
 		}
 		return output;
 	}
 	
 	Attribute findAttribute(string input_name) {
-		return columns[indices[input_name]];
+		return columns[indices[symbols().find(input_name)]];
 	}
 	Attribute* findAttributeP(string input_name) {
-		return &columns[indices[input_name]];
+		return &columns[indices[symbols().find(input_name)]];
+	}
+	PrimaryKeyIndex* findPrimaryIndex() {
+		//the primary key index, made the first time it is needed. 0 if there is no primary key
+		vector<Attribute*> keyColumns = primaryKeyColumns();
+		if(keyColumns.empty()) {
+			return 0;
+		}
+		if(primaryIndex.empty()) {
+			primaryIndex.push_back(PrimaryKeyIndex(keyColumns));
+		}
+		return &primaryIndex[0];
+	}
+	vector<Attribute*> primaryKeyColumns() {
+		//empty if there is no primary key or it names a missing attribute
+		vector<Attribute*> keyColumns;
+		for(int i = 0; i < primaryKeys.size(); i++) {
+			int col = columnIndex(symbols().find(primaryKeys[i]));
+			if(col == -1) {
+				return vector<Attribute*>();
+			}
+			keyColumns.push_back(&columns[col]);
+		}
+		return keyColumns;
+	}
+	SecondaryIndex* findIndex(int attrId) {
+		//first secondary index on the attribute, 0 if there is none
+		for(int i = 0; i < secondaryIndexes.size(); i++) {
+			if(secondaryIndexes[i].attrId == attrId) {
+				return &secondaryIndexes[i];
+			}
+		}
+		return 0;
+	}
+	BitmapIndex* findBitmapIndex(int attrId) {
+		for(int i = 0; i < bitmapIndexes.size(); i++) {
+			if(bitmapIndexes[i].attrId == attrId) {
+				return &bitmapIndexes[i];
+			}
+		}
+		return 0;
+	}
+	CrackerIndex* findCracker(int attrId) {
+		for(int i = 0; i < crackers.size(); i++) {
+			if(crackers[i].attrId == attrId) {
+				return &crackers[i];
+			}
+		}
+		return 0;
+	}
+	void setSortedBy(vector<int> attrIds) {
+		//the rows are in ascending order of attrIds (e.g. a query ordered them), until they change
+		sortedBy = attrIds;
+		sortedChanges = changeCount();
+		sortedHeight = getHeight();
+	}
+	vector<int> sortOrder() {
+		//sortedBy if nothing changed since it was recorded. Otherwise the rows are checked for
+		//being stored in primary key order (clustered), which then becomes the recorded order
+		if(columns.empty()) {
+			return vector<int>();
+		}
+		if(sortedHeight != getHeight() || sortedChanges != changeCount()) {
+			vector<Attribute*> keyColumns = primaryKeyColumns();
+			for(int i = 0; i < keyColumns.size(); i++) {
+				if(!keyColumns[i]->loaded) {
+					return vector<int>(); //can't tell yet
+				}
+			}
+			vector<int> keyIds;
+			if(!keyColumns.empty() && inOrder(keyColumns)) {
+				keyIds = findSymbols(primaryKeys);
+			}
+			setSortedBy(keyIds);
+		}
+		return sortedBy;
+	}
+	bool inOrder(vector<Attribute*>& keyColumns) {
+		//whether every row's key is >= the previous row's, INTEGER columns comparing as ints
+		for(int row = 1; row < getHeight(); row++) {
+			for(int i = 0; i < keyColumns.size(); i++) {
+				int order = keyColumns[i]->compareRows(row - 1, row);
+				if(order < 0) {
+					break;
+				}
+				if(order > 0) {
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+	long changeCount() {
+		long count = 0;
+		for(int i = 0; i < columns.size(); i++) {
+			count += columns[i].changes;
+		}
+		return count;
+	}
+	int columnIndex(int nameId) {
+		//-1 if the relation has no such attribute
+		map<int, int>::iterator it = indices.find(nameId);
+		return (it == indices.end() ? -1 : it->second);
 	}
 	
 	
 /*	int getIndex(string attribName, string uniqueValue){
 		int col
 		for(int i = 0; i < columns.size(); i++) {
-			output.push_back(columns[i].cells[index]);
+			output.push_back(columns[i].getElement(index));
 		}
 		return output;
 	}*/
 
 	void setElement(int x, int y, string value) {
-		columns[x].cells[y] = value;
+		columns[x].setElement(y, value);
 	}
 
 	string getName() {
@@ -112,7 +254,7 @@ public:
 		return result;
 	}
 	
-	string stringify() {
+	string stringifyHeader() {
 		string table = "(";
 		int j = 0;	
 		for(int i = 0; i < columns.size(); i++) {
@@ -123,6 +265,11 @@ public:
 				table = table + columns[i].getName() + " " + columns[i].getType() + ", ";
 			}
 		}
+		return table;
+	}
+	
+	string stringify() {
+		string table = stringifyHeader();
 	
 		for(int i = 0; i < getHeight(); i++) {
 			table = table + "(";	
@@ -131,15 +278,15 @@ public:
 			
 				if(j == (columns.size()-1)) {
 					if( columns[j].isInt() ) {
-						table = table + columns[j].cells[i] + ")";
+						table = table + columns[j].getElement(i) + ")";
 					} else {
-						table = table + "\"" + columns[j].cells[i] + "\")";
+						table = table + "\"" + columns[j].getElement(i) + "\")";
 					}
 				} else {
 					if( columns[j].isInt() ) {
-						table = table + columns[j].cells[i] + ", ";
+						table = table + columns[j].getElement(i) + ", ";
 					} else {
-						table = table + "\"" + columns[j].cells[i] + "\", ";
+						table = table + "\"" + columns[j].getElement(i) + "\", ";
 					}
 				}				
 			
@@ -150,6 +297,134 @@ public:
 		return table;
 	}
 	
+	string stringifyColumns(TaskPool* pool = 0) {
+		//Columnar file layout: the usual header line, "COLUMNAR <height>", a line of fixed-width
+		//byte offsets (one per column), then every column's cells, one cell per line.
+		//A reader can seek straight to the columns it needs without parsing the others.
+		//Encoded columns are flagged with a letter after their offset:
+		//	'D' dictionary: the dictionary size, the dictionary, then one code per row
+		//	'F' bitpacked INTEGER: "base bits", then the packed 64 bit words as raw bytes
+		//	'R' run length INTEGER: the number of runs, then "value length" per run
+		//The directory is followed by the zone maps: "ZONES <rows per block> <blocks>", then
+		//for every column the min and max of each block, one per line.
+		//"COLUMNAR" is also followed by a checksum of the sections, which the relation's .idx
+		//file repeats so indexes can tell whether they still match the file.
+		//With a pool, the sections of the columns are put together at the same time.
+		int height = (columns.size() == 0 ? 0 : getHeight());
+		vector<string> sections(columns.size());
+		long directorySize = (columns.size() == 0 ? 1 : columns.size() * 11);
+		TaskGroup group;
+		for(int i = 0; i < columns.size(); i++) {
+			if(pool == 0) {
+				stringifySection(i, height, sections[i]);
+			} else {
+				pool->submit(group, boost::bind(&Relation::stringifySection, this, i, height, boost::ref(sections[i])));
+			}
+		}
+		if(pool != 0) {
+			pool->wait(group);
+		}
+		for(int i = 0; i < columns.size(); i++) {
+			if(sectionKind(columns[i]) != 0) {
+				directorySize++;
+			}
+		}
+		
+		fileChecksum = Helpers::checksum("");
+		for(int i = 0; i < sections.size(); i++) {
+			fileChecksum = Helpers::checksum(sections[i], fileChecksum);
+		}
+		stringstream columnar;
+		columnar << "COLUMNAR " << height << " " << fileChecksum << "\n";
+		string header = stringifyHeader() + columnar.str();
+		string zoneMaps = stringifyZones(height);
+		long offset = header.size() + directorySize + zoneMaps.size();
+		stringstream directory;
+		for(int i = 0; i < sections.size(); i++) {
+			directory << setw(10) << setfill('0') << offset;
+			if(sectionKind(columns[i]) != 0) {
+				directory << sectionKind(columns[i]);
+			}
+			directory << (i == sections.size()-1 ? "" : " ");
+			offset += sections[i].size();
+		}
+		directory << '\n';
+		
+		string table = header + directory.str() + zoneMaps;
+		for(int i = 0; i < sections.size(); i++) {
+			table += sections[i];
+		}
+		return table;
+	}
+	
+	void stringifySection(int i, int height, string& section) {
+		//column i's part of stringifyColumns, which touches no other column
+		Attribute& column = columns[i];
+		column.chooseEncoding();
+		char kind = sectionKind(column);
+		if(kind == 'F') {
+			BitPackedInts& packed = column.packedInts;
+			section += intToString(packed.base) + " " + intToString(packed.bits) + '\n';
+			if(!packed.words.empty()) {
+				section.append((const char*)&packed.words[0], packed.words.size() * sizeof(boost::uint64_t));
+			}
+		} else if(kind == 'R') {
+			RunLengthInts& runs = column.runs;
+			section += intToString(runs.values.size()) + '\n';
+			for(int j = 0; j < runs.values.size(); j++) {
+				section += intToString(runs.values[j]) + " " + intToString(runs.ends[j] - (j == 0 ? 0 : runs.ends[j-1])) + '\n';
+			}
+		} else if(kind == 'D') {
+			section += intToString(column.dictionary.size()) + '\n';
+			for(int j = 0; j < column.dictionary.size(); j++) {
+				section += column.dictionary[j];
+				section += '\n';
+			}
+			for(int j = 0; j < height; j++) {
+				section += intToString(column.codes[j]);
+				section += '\n';
+			}
+		} else {
+			for(int j = 0; j < height; j++) {
+				boost::string_ref cell = column.getView(j);
+				section.append(cell.data(), cell.size());
+				section += '\n';
+			}
+		}
+		column.buildZones(); //exact bounds for stringifyZones, updates may have left them loose
+	}
+	
+	string stringifyZones(int height) {
+		//the zones were just rebuilt by stringifySection
+		int blocks = (height + ZONE_ROWS - 1) / ZONE_ROWS;
+		string zoneMaps = "ZONES " + intToString(ZONE_ROWS) + " " + intToString(blocks) + "\n";
+		for(int i = 0; i < columns.size(); i++) {
+			Attribute& column = columns[i];
+			for(int j = 0; j < blocks; j++) {
+				ZoneMap& zone = column.zones[j];
+				if(column.isInt()) {
+					zoneMaps += intToString(zone.minInt) + '\n' + intToString(zone.maxInt) + '\n';
+				} else {
+					zoneMaps += zone.minStr + '\n' + zone.maxStr + '\n';
+				}
+			}
+		}
+		return zoneMaps;
+	}
+	
+	char sectionKind(Attribute& column) {
+		if(column.encoded) {
+			return 'D';
+		}
+		if(column.packed) {
+			return 'F';
+		}
+		if(column.runLength) {
+			return 'R';
+		}
+		return 0;
+	}
+	
 	//void update(vector< pair<string colName, string newVal> > setList, condition_tree/list)
 	
 	void print() {
@@ -159,9 +434,9 @@ public:
 		}
 		cout << endl;
 		//Prints the tuples (elements/cells)
-		for(int i = 0; i < columns[0].cells.size(); i++) {
+		for(int i = 0; i < columns[0].getSize(); i++) {
 			for(int j = 0; j < columns.size(); j++) {
-				cout << setw (19)<<columns[j].cells[i];
+				cout << setw (19)<<columns[j].getElement(i);
 			}
 			cout << endl;
 		}
@@ -208,6 +483,13 @@ public:
 	}
 	
 	void parseTuples(string line) {
+		vector<string> cells = parseTupleCells(line);
+		if(cells.size() != 0) {
+			addTuple(cells);
+		}
+	}
+	
+	vector<string> parseTupleCells(string line) {
 		vector<string> cells;
 		string temp = "";
 		for(int i = 0; i < line.size(); i++) {
@@ -233,16 +515,28 @@ public:
 				break;
 			}
 		}
-		
-		if(cells.size() != 0) {
-			addTuple(cells);
-		}
+		return cells;
 	}
 	
 	int getHeight() {
+		//columns not loaded yet are empty, any loaded one has the real height
+		for(int i = 0; i < columns.size(); i++) {
+			if(columns[i].loaded) {
+				return columns[i].getSize();
+			}
+		}
 		return (columns[0].getSize());
 	}
 	
+	bool isFullyLoaded() {
+		for(int i = 0; i < columns.size(); i++) {
+			if(!columns[i].loaded) {
+				return false;
+			}
+		}
+		return true;
+	}
+	
 	
 	Relation Relation::operator+(const Relation& right) {
 		Relation result = *this;
@@ -300,8 +594,7 @@ public:
 	void deleteTuple(int index) {
 		
 		for(int i = 0; i < columns.size(); i++) {
-			vector<string>::iterator iter = columns[i].cells.begin() + index;
-			columns[i].cells.erase(iter);		
+			columns[i].eraseCell(index);
 		}
 	}
 
@@ -335,7 +628,7 @@ public:
 	vector<string> constructTupleFromIndex(int index) {
 		vector<string> tuple;
 		for(int i = 0; i < columns.size(); i++) {
-			tuple.push_back(columns[i].cells[index]);
+			tuple.push_back(columns[i].getElement(index));
 		}
 		
 		
@@ -389,7 +682,7 @@ public:
 				
 				for(int j = 0; j < table1.columns.size(); j++) {
 					
-					tuple1.push_back( table1.columns[j].cells[i] );
+					tuple1.push_back( table1.columns[j].getElement(i) );
 				}
 				for(int k = 0; k < tuple1.size(); k++) {
 					cout << tuple1[k] << '\t';
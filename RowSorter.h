@@ -0,0 +1,298 @@
+#ifndef ROWSORTER_H
+#define ROWSORTER_H
+
+#include <vector>
+#include <queue>
+#include <string>
+#include <fstream>
+#include <cstdio>
+#include <algorithm>
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+#include "Relation.h"
+#include "TaskPool.h"
+
+using namespace std;
+
+//Sort engine for order ( attribute-list ): sorts a permutation of a relation's rows, never
+//the cells themselves. Several keys are sorted least significant first, each pass stable, so
+//ties on every key keep the rows' own order.
+//INTEGER keys: LSD radix sort, four passes over a byte of the value each (a pass where every
+//row has the same byte is skipped), reading the column once.
+//VARCHAR keys: the permutation is cut into one run per thread of the pool, each run sorted by
+//a task of its own, then the runs are merged all at once through a heap.
+//The columns must stay unchanged and be safe to read from several threads while sorting
+//(e.g. an arena Relation the rows were copied into).
+//Input larger than the sort memory is sorted a run at a time, every sorted run written to a
+//temporary file (SortRunWriter) and read back through a read-ahead buffer (SortRunReader)
+//for one merge of all the runs, see OrderOp.
+
+const int SORT_RUN_BUFFER = 1 << 16; //bytes written or read ahead at a time per run file
+const int SORT_MERGE_FAN_IN = 128; //run files merged at once
+
+int processId() {
+	//run file names hold it, so processes sorting into the same directory keep apart
+#ifdef _WIN32
+	return _getpid();
+#else
+	return getpid();
+#endif
+}
+
+class RowOrder{
+//strict weak ordering of rows by one VARCHAR column
+public:
+	RowOrder(Attribute* Column) {
+		column = Column;
+	}
+
+	bool operator()(int a, int b) const {
+		return column->getView(a).compare(column->getView(b)) < 0;
+	}
+
+private:
+	Attribute* column;
+};
+
+class RowSorter{
+public:
+	int tasks;		//tasks the sort ran on the pool
+	int stolen;
+
+	RowSorter(Relation* Rel, vector<int> KeyCols, TaskPool* Pool) {
+		rel = Rel;
+		keyCols = KeyCols;
+		pool = Pool;
+		tasks = 0;
+		stolen = 0;
+	}
+
+	void sort(vector<int>& rows) {
+		//orders rows by the key columns, stably
+		for(int k = keyCols.size() - 1; k >= 0; k--) {
+			Attribute& column = rel->columns[keyCols[k]];
+			if(column.isInt()) {
+				radixSort(column, rows);
+			} else {
+				mergeSort(column, rows);
+			}
+		}
+	}
+
+private:
+	Relation* rel;
+	vector<int> keyCols;	//columns of rel, most significant first
+	TaskPool* pool;
+
+	void radixSort(Attribute& column, vector<int>& rows) {
+		int n = rows.size();
+		vector<unsigned int> keys(n);
+		for(int i = 0; i < n; i++) {
+			keys[i] = (unsigned int)column.getInt(rows[i]) ^ 0x80000000u; //negative values first
+		}
+		vector<unsigned int> keyBuffer(n);
+		vector<int> rowBuffer(n);
+		for(int shift = 0; shift < 32; shift += 8) {
+			int counts[257] = {0};
+			for(int i = 0; i < n; i++) {
+				counts[((keys[i] >> shift) & 0xff) + 1]++;
+			}
+			if(n == 0 || counts[((keys[0] >> shift) & 0xff) + 1] == n) {
+				continue; //nothing would move
+			}
+			for(int b = 0; b < 256; b++) {
+				counts[b + 1] += counts[b];
+			}
+			for(int i = 0; i < n; i++) {
+				int at = counts[(keys[i] >> shift) & 0xff]++;
+				keyBuffer[at] = keys[i];
+				rowBuffer[at] = rows[i];
+			}
+			keys.swap(keyBuffer);
+			rows.swap(rowBuffer);
+		}
+	}
+
+	void mergeSort(Attribute& column, vector<int>& rows) {
+		int runs = min(pool->threads(), (int)rows.size());
+		if(runs <= 1) {
+			stable_sort(rows.begin(), rows.end(), RowOrder(&column));
+			return;
+		}
+		vector<int> starts;
+		for(int r = 0; r <= runs; r++) {
+			starts.push_back((long)rows.size() * r / runs);
+		}
+		TaskGroup group;
+		for(int r = 0; r < runs; r++) {
+			pool->submit(group, boost::bind(&RowSorter::sortRun, this, &column, &rows, starts[r], starts[r + 1]));
+		}
+		pool->wait(group);
+		tasks += group.tasks;
+		stolen += group.stolen;
+		merge(column, rows, starts);
+	}
+
+	void sortRun(Attribute* column, vector<int>* rows, int start, int end) {
+		//one task
+		stable_sort(rows->begin() + start, rows->begin() + end, RowOrder(column));
+	}
+
+	struct RunHead{
+		int run;	//which run
+		int pos;	//its next row, a position in rows
+	};
+
+	class LaterHead{
+	//heap order: the smallest row first, of equal ones the one of the earliest run, which keeps the merge stable
+	public:
+		LaterHead(Attribute* Column, vector<int>* Rows) {
+			column = Column;
+			rows = Rows;
+		}
+
+		bool operator()(const RunHead& a, const RunHead& b) const {
+			int order = column->getView((*rows)[a.pos]).compare(column->getView((*rows)[b.pos]));
+			return (order != 0 ? order > 0 : a.run > b.run);
+		}
+
+	private:
+		Attribute* column;
+		vector<int>* rows;
+	};
+
+	void merge(Attribute& column, vector<int>& rows, vector<int>& starts) {
+		//the sorted runs rows[starts[r], starts[r+1]) into one
+		int runs = starts.size() - 1;
+		priority_queue<RunHead, vector<RunHead>, LaterHead> heads(LaterHead(&column, &rows));
+		for(int r = 0; r < runs; r++) {
+			if(starts[r] < starts[r + 1]) {
+				RunHead head;
+				head.run = r;
+				head.pos = starts[r];
+				heads.push(head);
+			}
+		}
+		vector<int> merged;
+		merged.reserve(rows.size());
+		while(!heads.empty()) {
+			RunHead head = heads.top();
+			heads.pop();
+			merged.push_back(rows[head.pos]);
+			head.pos++;
+			if(head.pos < starts[head.run + 1]) {
+				heads.push(head);
+			}
+		}
+		rows.swap(merged);
+	}
+};
+
+class SortRunWriter{
+//writes tuples to a run file: every cell as its length (4 bytes) then its characters
+public:
+	SortRunWriter(string Path) {
+		file.open(Path.c_str(), ios::out | ios::binary | ios::trunc);
+	}
+
+	bool good() {
+		return file.good();
+	}
+
+	void write(Relation* rel, int row) {
+		for(int c = 0; c < rel->columns.size(); c++) {
+			boost::string_ref cell = rel->columns[c].getView(row);
+			unsigned int length = cell.size();
+			buffer.append((const char*)&length, sizeof(length));
+			buffer.append(cell.data(), cell.size());
+		}
+		if(buffer.size() >= SORT_RUN_BUFFER) {
+			flush();
+		}
+	}
+
+	void write(vector<string>& tuple) {
+		for(int c = 0; c < tuple.size(); c++) {
+			unsigned int length = tuple[c].size();
+			buffer.append((const char*)&length, sizeof(length));
+			buffer.append(tuple[c]);
+		}
+		if(buffer.size() >= SORT_RUN_BUFFER) {
+			flush();
+		}
+	}
+
+	bool close() {
+		flush();
+		file.close();
+		return !file.fail();
+	}
+
+private:
+	ofstream file;
+	string buffer;
+
+	void flush() {
+		file.write(buffer.data(), buffer.size());
+		buffer.clear();
+	}
+};
+
+class SortRunReader{
+//reads back, in order, the tuples of a run file, SORT_RUN_BUFFER bytes ahead
+public:
+	vector<string> tuple;	//the current tuple
+
+	SortRunReader(string Path, int Columns) {
+		file.open(Path.c_str(), ios::in | ios::binary);
+		tuple.resize(Columns);
+		buffer.resize(SORT_RUN_BUFFER);
+		pos = 0;
+		end = 0;
+	}
+
+	bool next() {
+		//false once the run is exhausted
+		for(int c = 0; c < tuple.size(); c++) {
+			unsigned int length;
+			if(!read((char*)&length, sizeof(length))) {
+				return false;
+			}
+			tuple[c].resize(length);
+			if(length > 0 && !read(&tuple[c][0], length)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+private:
+	ifstream file;
+	vector<char> buffer;
+	int pos;	//next unread byte of buffer
+	int end;	//bytes in buffer
+
+	bool read(char* out, int bytes) {
+		while(bytes > 0) {
+			if(pos == end) {
+				file.read(&buffer[0], buffer.size());
+				end = file.gcount();
+				pos = 0;
+				if(end == 0) {
+					return false;
+				}
+			}
+			int chunk = min(bytes, end - pos);
+			memcpy(out, &buffer[pos], chunk);
+			out += chunk;
+			pos += chunk;
+			bytes -= chunk;
+		}
+		return true;
+	}
+};
+
+#endif
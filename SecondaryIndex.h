@@ -0,0 +1,254 @@
+#ifndef SECONDARYINDEX_H
+#define SECONDARYINDEX_H
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "Attribute.h"
+
+using namespace std;
+
+//Secondary indexes (CREATE INDEX name ON relation (attribute)): a B+tree from the values of
+//one column to the rows holding them, for equality and range lookups.
+//Nodes live in one vector and refer to each other by position, so a Relation (and its
+//indexes) can still be copied by value.
+
+const int BTREE_NODE_KEYS = 64; //a node splits once it holds more keys than this
+
+template <class Key>
+class BPlusTree{
+public:
+	struct Node{
+		bool leaf;
+		vector<Key> keys;
+		vector<int> children;	//internal nodes: keys.size()+1 node ids, leaves: the row of each key
+		int next;				//leaves: the next leaf to the right, -1 for the last one
+	};
+	vector<Node> nodes;
+	int root;
+	int count;
+
+	BPlusTree() {
+		clear();
+	}
+
+	void clear() {
+		nodes.clear();
+		nodes.push_back(newNode(true));
+		root = 0;
+		count = 0;
+	}
+
+	void insert(const Key& key, int row) {
+		//equal keys are kept, one entry per row
+		Key upKey;
+		int upNode;
+		if(insertInto(root, key, row, upKey, upNode)) {
+			//the root split: the tree grows one level
+			Node top = newNode(false);
+			top.keys.push_back(upKey);
+			top.children.push_back(root);
+			top.children.push_back(upNode);
+			nodes.push_back(top);
+			root = nodes.size() - 1;
+		}
+		count++;
+	}
+
+	bool range(const Key* low, bool lowInclusive, const Key* high, bool highInclusive, int limit, vector<int>& rows) {
+		//rows of every key between low and high (0: unbounded), in key order.
+		//false, with rows incomplete, as soon as more than limit rows match
+		int id = firstLeaf(low);
+		for(; id != -1; id = nodes[id].next) {
+			Node& leaf = nodes[id];
+			for(int i = 0; i < leaf.keys.size(); i++) {
+				const Key& key = leaf.keys[i];
+				if(low != 0 && (key < *low || (!lowInclusive && !(*low < key)))) {
+					continue;
+				}
+				if(high != 0 && (*high < key || (!highInclusive && !(key < *high)))) {
+					return true;
+				}
+				if(rows.size() >= limit) {
+					return false;
+				}
+				rows.push_back(leaf.children[i]);
+			}
+		}
+		return true;
+	}
+
+	void entries(vector<Key>& keys, vector<int>& rows) {
+		//every (key, row) in key order
+		for(int id = firstLeaf(0); id != -1; id = nodes[id].next) {
+			keys.insert(keys.end(), nodes[id].keys.begin(), nodes[id].keys.end());
+			rows.insert(rows.end(), nodes[id].children.begin(), nodes[id].children.end());
+		}
+	}
+
+private:
+	Node newNode(bool leaf) {
+		Node node;
+		node.leaf = leaf;
+		node.next = -1;
+		return node;
+	}
+
+	int firstLeaf(const Key* low) {
+		//leftmost leaf that can hold a key >= low (the leftmost leaf if low is 0).
+		//Everything under child i of an internal node is <= keys[i]
+		int id = root;
+		while(!nodes[id].leaf) {
+			vector<Key>& keys = nodes[id].keys;
+			int pos = (low == 0 ? 0 : lower_bound(keys.begin(), keys.end(), *low) - keys.begin());
+			id = nodes[id].children[pos];
+		}
+		return id;
+	}
+
+	bool insertInto(int id, const Key& key, int row, Key& upKey, int& upNode) {
+		//true if node id had to split: upKey and upNode are then the separator and the
+		//new right sibling its parent has to take
+		int pos = upper_bound(nodes[id].keys.begin(), nodes[id].keys.end(), key) - nodes[id].keys.begin();
+		if(nodes[id].leaf) {
+			nodes[id].keys.insert(nodes[id].keys.begin() + pos, key);
+			nodes[id].children.insert(nodes[id].children.begin() + pos, row);
+		} else {
+			Key childKey;
+			int childNode;
+			if(!insertInto(nodes[id].children[pos], key, row, childKey, childNode)) {
+				return false;
+			}
+			nodes[id].keys.insert(nodes[id].keys.begin() + pos, childKey);
+			nodes[id].children.insert(nodes[id].children.begin() + pos + 1, childNode);
+		}
+		if(nodes[id].keys.size() <= BTREE_NODE_KEYS) {
+			return false;
+		}
+		split(id, upKey, upNode);
+		return true;
+	}
+
+	void split(int id, Key& upKey, int& upNode) {
+		Node right = newNode(nodes[id].leaf);
+		Node& left = nodes[id];
+		int mid = left.keys.size() / 2;
+		if(left.leaf) {
+			right.keys.assign(left.keys.begin() + mid, left.keys.end());
+			right.children.assign(left.children.begin() + mid, left.children.end());
+			left.keys.resize(mid);
+			left.children.resize(mid);
+			right.next = left.next;
+			upKey = right.keys[0];
+		} else {
+			upKey = left.keys[mid];
+			right.keys.assign(left.keys.begin() + mid + 1, left.keys.end());
+			right.children.assign(left.children.begin() + mid + 1, left.children.end());
+			left.keys.resize(mid);
+			left.children.resize(mid + 1);
+		}
+		nodes.push_back(right); //left is invalid from here on
+		upNode = nodes.size() - 1;
+		if(nodes[id].leaf) {
+			nodes[id].next = upNode;
+		}
+	}
+};
+
+class SecondaryIndex{
+//INTEGER columns are keyed by their value (as getInt reads it), VARCHAR columns by their text.
+public:
+	string name;
+	int attrId;			//symbol id of the indexed attribute
+	bool isInt;
+	BPlusTree<int> ints;
+	BPlusTree<string> strings;
+	int indexedRows;	//rows 0..indexedRows-1 of the column are in the tree
+	int builtChanges;	//the column's changes count the tree is up to date with
+
+	SecondaryIndex(string Name, Attribute& column) {
+		name = Name;
+		attrId = column.nameId;
+		isInt = column.isInt();
+		indexedRows = 0;
+		builtChanges = column.changes;
+	}
+
+	void refresh(Attribute& column) {
+		//catches up with the column: appended rows are added, any other change rebuilds the tree
+		if(column.changes != builtChanges || indexedRows > column.getSize()) {
+			ints.clear();
+			strings.clear();
+			indexedRows = 0;
+			builtChanges = column.changes;
+		}
+		for(; indexedRows < column.getSize(); indexedRows++) {
+			if(isInt) {
+				ints.insert(column.getInt(indexedRows), indexedRows);
+			} else {
+				strings.insert(column.getElement(indexedRows), indexedRows);
+			}
+		}
+	}
+
+	void add(const string& key, int row) {
+		if(isInt) {
+			ints.insert(leadingInt(key), row);
+		} else {
+			strings.insert(key, row);
+		}
+		indexedRows = max(indexedRows, row + 1);
+	}
+
+	bool lookup(const string* low, bool lowInclusive, const string* high, bool highInclusive, int limit, vector<int>& rows) {
+		//rows whose value is between low and high (0: unbounded), in row order.
+		//false if more than limit rows match
+		bool found;
+		if(isInt) {
+			int lowInt = (low == 0 ? 0 : leadingInt(*low));
+			int highInt = (high == 0 ? 0 : leadingInt(*high));
+			found = ints.range(low == 0 ? 0 : &lowInt, lowInclusive, high == 0 ? 0 : &highInt, highInclusive, limit, rows);
+		} else {
+			found = strings.range(low, lowInclusive, high, highInclusive, limit, rows);
+		}
+		if(found) {
+			sort(rows.begin(), rows.end());
+		}
+		return found;
+	}
+
+	void keyOrder(vector<int>& rows) {
+		//every row, in order of its value, for reading the column sorted
+		if(isInt) {
+			vector<int> keys;
+			ints.entries(keys, rows);
+		} else {
+			vector<string> keys;
+			strings.entries(keys, rows);
+		}
+	}
+
+	string stringify() {
+		//"INDEX <name> <attribute> <entries>", then "row key" per entry in key order
+		string out;
+		vector<int> rows;
+		if(isInt) {
+			vector<int> keys;
+			ints.entries(keys, rows);
+			out = "INDEX " + name + " " + symbols().name(attrId) + " " + intToString(rows.size()) + "\n";
+			for(int i = 0; i < rows.size(); i++) {
+				out += intToString(rows[i]) + " " + intToString(keys[i]) + "\n";
+			}
+		} else {
+			vector<string> keys;
+			strings.entries(keys, rows);
+			out = "INDEX " + name + " " + symbols().name(attrId) + " " + intToString(rows.size()) + "\n";
+			for(int i = 0; i < rows.size(); i++) {
+				out += intToString(rows[i]) + " " + keys[i] + "\n";
+			}
+		}
+		return out;
+	}
+};
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef SYMBOLS_H
+#define SYMBOLS_H
+
+#include <string>
+#include <vector>
+#include <boost/unordered_map.hpp>
+
+using namespace std;
+
+//Global symbol table. Keywords, punctuation, relation names and attribute names are interned
+//into small integer ids once, when they are scanned or defined, so keyword matching, catalog
+//lookups and column resolution compare ints instead of strings.
+//Only names get interned (intern); literals are just looked up (find), so INSERTing
+//a million values doesn't grow the table.
+
+//Keywords and punctuation are interned first, in this order, so their ids are constants.
+enum Symbol { SYM_LPAREN=0, SYM_RPAREN, SYM_COMMA, SYM_QUOTE, SYM_MINUS, SYM_PLUS, SYM_STAR, SYM_SEMICOLON,
+	SYM_ARROW, SYM_ASSIGN, SYM_EQ, SYM_NEQ, SYM_LT, SYM_GT, SYM_LTE, SYM_GTE, SYM_PREFIX, SYM_AND, SYM_OR,
+	KW_SELECT, KW_PROJECT, KW_RENAME, KW_INSERT, KW_INTO, KW_VALUES, KW_FROM, KW_RELATION,
+	KW_CREATE, KW_TABLE, KW_PRIMARY, KW_KEY, KW_VARCHAR, KW_INTEGER, KW_UPDATE, KW_SET, KW_WHERE,
+	KW_DELETE, KW_OPEN, KW_CLOSE, KW_WRITE, KW_SHOW, KW_EXIT, KW_INDEX, KW_ON, KW_BITMAP, KW_CRACKING, KW_OFF, KW_THREADS, KW_JOIN, KW_ORDER, KW_SORT, KW_MEMORY, KW_LIMIT, KW_GROUP, KW_AGGREGATE,
+	KW_COUNT, KW_SUM, KW_MIN, KW_MAX, KW_AVG, SYMBOL_COUNT };
+
+const char* symbolSpellings[SYMBOL_COUNT] = { "(", ")", ",", "\"", "-", "+", "*", ";",
+	"<-", "=", "==", "!=", "<", ">", "<=", ">=", "^=", "&&", "||",
+	"select", "project", "rename", "INSERT", "INTO", "VALUES", "FROM", "RELATION",
+	"CREATE", "TABLE", "PRIMARY", "KEY", "VARCHAR", "INTEGER", "UPDATE", "SET", "WHERE",
+	"DELETE", "OPEN", "CLOSE", "WRITE", "SHOW", "EXIT", "INDEX", "ON", "BITMAP", "CRACKING", "OFF", "THREADS", "join", "order", "SORT", "MEMORY", "limit", "group", "aggregate",
+	"count", "sum", "min", "max", "avg" };
+
+const int NO_SYMBOL = -1;
+
+class SymbolTable{
+public:
+	SymbolTable() {
+		for(int i = 0; i < SYMBOL_COUNT; i++) {
+			intern(symbolSpellings[i]);
+		}
+	}
+
+	int intern(const string& name) {
+		//id of name, adding it if it is new
+		boost::unordered_map<string, int>::iterator it = ids.find(name);
+		if(it != ids.end()) {
+			return it->second;
+		}
+		names.push_back(name);
+		ids[name] = names.size() - 1;
+		return names.size() - 1;
+	}
+
+	int find(const string& name) {
+		//id of name, NO_SYMBOL if it was never interned
+		boost::unordered_map<string, int>::iterator it = ids.find(name);
+		return (it == ids.end() ? NO_SYMBOL : it->second);
+	}
+
+	const string& name(int id) {
+		return names[id];
+	}
+
+private:
+	boost::unordered_map<string, int> ids;
+	vector<string> names;
+};
+
+SymbolTable& symbols() {
+	static SymbolTable table;
+	return table;
+}
+
+vector<int> findSymbols(vector<string>& names) {
+	vector<int> found;
+	for(int i = 0; i < names.size(); i++) {
+		found.push_back(symbols().find(names[i]));
+	}
+	return found;
+}
+
+#endif
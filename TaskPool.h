@@ -0,0 +1,277 @@
+#ifndef TASKPOOL_H
+#define TASKPOOL_H
+
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <boost/thread.hpp>
+#include <boost/function.hpp>
+#include <boost/bind/bind.hpp>
+#include <boost/exception_ptr.hpp>
+
+using namespace std;
+
+//The DBMS's one pool of worker threads (SET THREADS n: n-1 workers plus the thread waiting
+//for the tasks), shared by every parallel scan, join, sort, load and write.
+//Work stealing: every worker has its own deque of tasks. It runs the newest of its own tasks
+//first, and once it has none it steals the oldest half of another deque, so a burst of tasks
+//submitted from one thread spreads out over the workers in a few steals.
+//Tasks are submitted to a TaskGroup and waited for as a group. The waiting thread runs
+//tasks too, so with SET THREADS 1 (no workers) everything still runs, on the caller.
+//If a task throws, the rest of its group still runs and wait() rethrows the first exception.
+
+const int THREADS_PER_CORE = 4; //SET THREADS allows this many threads per hardware thread
+
+typedef boost::function<void()> Task;
+
+class TaskGroup{
+//the tasks one operation waits for, counted for its query's stats
+public:
+	int tasks;	//tasks that ran
+	int stolen;	//tasks that ran after being stolen by another worker
+
+	TaskGroup() {
+		tasks = 0;
+		stolen = 0;
+		pending = 0;
+	}
+
+private:
+	friend class TaskPool;
+	int pending;	//submitted and not finished yet
+	boost::exception_ptr error;	//the first exception a task threw
+	boost::mutex lock;
+};
+
+class TaskPool{
+public:
+	TaskPool(int Threads) {
+		start(Threads);
+	}
+
+	~TaskPool() {
+		stop();
+	}
+
+	int threads() {
+		//workers plus the waiting thread
+		return workers.size() + 1;
+	}
+
+	static int maxThreads() {
+		//what SET THREADS is clamped to: more threads than this only add switching
+		return THREADS_PER_CORE * max(1, (int)boost::thread::hardware_concurrency());
+	}
+
+	void resize(int Threads) {
+		//only between operations, while no task is queued
+		stop();
+		start(Threads);
+	}
+
+	void submit(TaskGroup& group, Task task) {
+		{
+			boost::mutex::scoped_lock lock(group.lock);
+			group.pending++;
+		}
+		QueuedTask queued;
+		queued.task = task;
+		queued.group = &group;
+		queued.stolen = false;
+		Queue& queue = *queues[currentQueue()];
+		{
+			boost::mutex::scoped_lock lock(queue.lock);
+			queue.tasks.push_back(queued);
+		}
+		boost::mutex::scoped_lock lock(sleepLock);
+		queuedCount++;
+		wake.notify_one();
+	}
+
+	void wait(TaskGroup& group) {
+		//returns once every task submitted to group has run, running tasks meanwhile
+		int self = currentQueue();
+		while(!finished(group)) {
+			QueuedTask queued;
+			if(take(self, queued)) {
+				run(queued);
+				continue;
+			}
+			//the rest are running on workers: sleep until one of them finishes the group or
+			//queues more tasks (see run and submit)
+			boost::mutex::scoped_lock lock(sleepLock);
+			if(queuedCount == 0 && !finished(group)) {
+				wake.wait(lock);
+			}
+		}
+		if(group.error) {
+			boost::exception_ptr error = group.error;
+			group.error = boost::exception_ptr();
+			boost::rethrow_exception(error);
+		}
+	}
+
+private:
+	struct QueuedTask{
+		Task task;
+		TaskGroup* group;
+		bool stolen;
+	};
+	struct Queue{
+		boost::mutex lock;
+		deque<QueuedTask> tasks;	//back: newest
+	};
+	vector<Queue*> queues;	//0 for threads outside the pool, i for worker i
+	vector<boost::thread*> workers;
+	boost::thread_specific_ptr<int> queueOfThread;
+	boost::mutex sleepLock;
+	boost::condition_variable wake;
+	int queuedCount;	//tasks in all queues, guarded by sleepLock
+	bool stopping;
+	int nextVictim;
+
+	void start(int Threads) {
+		queuedCount = 0;
+		stopping = false;
+		nextVictim = 0;
+		queues.push_back(new Queue());
+		for(int i = 1; i < Threads; i++) {
+			queues.push_back(new Queue());
+		}
+		for(int i = 1; i < Threads; i++) {
+			workers.push_back(new boost::thread(boost::bind(&TaskPool::work, this, i)));
+		}
+	}
+
+	void stop() {
+		{
+			boost::mutex::scoped_lock lock(sleepLock);
+			stopping = true;
+			wake.notify_all();
+		}
+		for(int i = 0; i < workers.size(); i++) {
+			workers[i]->join();
+			delete workers[i];
+		}
+		workers.clear();
+		for(int i = 0; i < queues.size(); i++) {
+			delete queues[i];
+		}
+		queues.clear();
+	}
+
+	int currentQueue() {
+		return (queueOfThread.get() == 0 ? 0 : *queueOfThread);
+	}
+
+	void work(int self) {
+		queueOfThread.reset(new int(self));
+		while(true) {
+			QueuedTask queued;
+			if(take(self, queued)) {
+				run(queued);
+				continue;
+			}
+			boost::mutex::scoped_lock lock(sleepLock);
+			if(stopping) {
+				return;
+			}
+			if(queuedCount == 0) {
+				wake.wait(lock);
+			}
+		}
+	}
+
+	bool take(int self, QueuedTask& out) {
+		//the newest task of queue self, stealing half of another queue first if it is empty
+		if(!popNewest(self, out)) {
+			if(!steal(self) || !popNewest(self, out)) {
+				return false;
+			}
+		}
+		boost::mutex::scoped_lock lock(sleepLock);
+		queuedCount--;
+		return true;
+	}
+
+	bool popNewest(int self, QueuedTask& out) {
+		Queue& queue = *queues[self];
+		boost::mutex::scoped_lock lock(queue.lock);
+		if(queue.tasks.empty()) {
+			return false;
+		}
+		out = queue.tasks.back();
+		queue.tasks.pop_back();
+		return true;
+	}
+
+	bool steal(int self) {
+		//moves the oldest half of the first non empty queue after the last victim into queue self
+		vector<QueuedTask> loot;
+		for(int tried = 0; tried < queues.size() && loot.empty(); tried++) {
+			int victim;
+			{
+				boost::mutex::scoped_lock lock(sleepLock);
+				victim = nextVictim;
+				nextVictim = (nextVictim + 1) % queues.size();
+			}
+			if(victim == self) {
+				continue;
+			}
+			Queue& queue = *queues[victim];
+			boost::mutex::scoped_lock lock(queue.lock);
+			int half = (queue.tasks.size() + 1) / 2;
+			for(int i = 0; i < half; i++) {
+				loot.push_back(queue.tasks.front());
+				loot.back().stolen = true;
+				queue.tasks.pop_front();
+			}
+		}
+		if(loot.empty()) {
+			return false;
+		}
+		Queue& mine = *queues[self];
+		boost::mutex::scoped_lock lock(mine.lock);
+		mine.tasks.insert(mine.tasks.end(), loot.rbegin(), loot.rend()); //the oldest one is run first
+		return true;
+	}
+
+	bool finished(TaskGroup& group) {
+		boost::mutex::scoped_lock lock(group.lock);
+		return group.pending == 0;
+	}
+
+	void run(QueuedTask& queued) {
+		//a throwing task still counts as run, so wait() returns, and the worker lives on
+		boost::exception_ptr error;
+		try {
+			queued.task();
+		} catch(...) {
+			error = boost::current_exception();
+		}
+		TaskGroup& group = *queued.group;
+		bool last;
+		{
+			boost::mutex::scoped_lock lock(group.lock);
+			group.tasks++;
+			if(queued.stolen) {
+				group.stolen++;
+			}
+			if(error && !group.error) {
+				group.error = error;
+			}
+			//dropped before the group can finish: the waiting thread may already be throwing
+			//a copy of it, and copies share a count that isn't atomic
+			error = boost::exception_ptr();
+			group.pending--;
+			last = (group.pending == 0);
+		}
+		if(last) {
+			//the thread waiting for the group may be asleep in wait()
+			boost::mutex::scoped_lock lock(sleepLock);
+			wake.notify_all();
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,72 @@
+#include <iostream>
+#include "DBMS.h"
+
+using namespace std;
+
+//Times rentals join (userId == userId) customers, 1M rows on each side, with the radix
+//partitioned hash join at several SET THREADS settings, against the nested loop
+//select ( userId == customerId ) ( rentals * customers ). A 1M x 1M product is 10^12 pairs,
+//so the nested loop is timed on the first SAMPLE_RENTALS rentals and scaled up per pair.
+
+const int BENCH_ROWS = 1000000;
+const int SAMPLE_RENTALS = 100;
+const int SAMPLE_CUSTOMERS = 100000;
+
+double seconds(boost::posix_time::ptime start){
+	return (boost::posix_time::microsec_clock::local_time() - start).total_microseconds() / 1e6;
+}
+
+void fill(DBMS* dbms, int rentals, int customers){
+	dbms->Execute("CREATE TABLE rentals (rentalId INTEGER, userId INTEGER, title VARCHAR(20)) PRIMARY KEY (rentalId);");
+	dbms->Execute("CREATE TABLE customers (customerId INTEGER, name VARCHAR(20)) PRIMARY KEY (customerId);");
+	Relation* rentalRel = dbms->relsInMem[symbols().find("rentals")];
+	Relation* customerRel = dbms->relsInMem[symbols().find("customers")];
+	srand(315);
+	for(int i=0; i<rentals; i++){
+		vector<string> tuple;
+		tuple.push_back(intToString(i));
+		tuple.push_back(intToString(rand() % customers));
+		tuple.push_back("title" + intToString(i % 5000));
+		rentalRel->addTuple(tuple);
+	}
+	for(int i=0; i<customers; i++){
+		vector<string> tuple;
+		tuple.push_back(intToString(i));
+		tuple.push_back("customer" + intToString(i));
+		customerRel->addTuple(tuple);
+	}
+}
+
+long drain(Cursor cursor){
+	long rows = 0;
+	while(cursor.next()){
+		rows++;
+	}
+	return rows;
+}
+
+int main(){
+	DBMS* dbms = new DBMS(false, 0);
+	fill(dbms, BENCH_ROWS, BENCH_ROWS);
+	int threads[] = {1, 2, 4, 8};
+	for(int i=0; i<4; i++){
+		dbms->Execute("SET THREADS " + intToString(threads[i]) + ";");
+		boost::posix_time::ptime start = boost::posix_time::microsec_clock::local_time();
+		long rows = drain(dbms->from("rentals").join(dbms->from("customers"), "userId", "customerId").run());
+		QueryStats& stats = dbms->execEngine->lastStats;
+		cout<<"hash join, "<<threads[i]<<" threads: "<<rows<<" rows in "<<seconds(start)<<" s ("
+			<<stats.joinPartitions<<" partitions, "<<stats.tasks<<" tasks, "<<stats.stolenTasks<<" stolen)\n";
+	}
+	delete dbms;
+
+	dbms = new DBMS(false, 0);
+	fill(dbms, SAMPLE_RENTALS, SAMPLE_CUSTOMERS);
+	boost::posix_time::ptime start = boost::posix_time::microsec_clock::local_time();
+	long rows = drain(dbms->from("rentals").product(dbms->from("customers")).where(col("userId") == col("customerId")).run());
+	double sample = seconds(start);
+	double pairs = (double)SAMPLE_RENTALS * SAMPLE_CUSTOMERS;
+	cout<<"nested loop: "<<rows<<" rows of "<<pairs<<" pairs in "<<sample<<" s, "
+		<<sample / pairs * BENCH_ROWS * BENCH_ROWS<<" s estimated for "<<BENCH_ROWS<<" x "<<BENCH_ROWS<<"\n";
+	delete dbms;
+	return 0;
+}
@@ -1,17 +1,223 @@
 
 #include <iostream>//|
+#include <sstream>
+#include <cstdio>
 #include "DBMS.h"
 
 using namespace std;
 
-int main(){
+//Runs testIn.txt a line at a time, up to its first EXIT. The //> lines right under a line are
+//the output it has to print, compared cell by cell so column widths don't matter; other //
+//lines are notes. Then checks the query builder against the relations the script made, and
+//the task pool's handling of a task that throws.
+//Every difference is printed and makes the test exit non-zero.
 
-	DBMS* dbms1 = new DBMS(false, 7);
-	dbms1->ExecuteTxtFile("testIn.txt");
-	delete dbms1;
-	cout<<"LEAVING MAIN!!!\n\n\n";	
-		
-	return 0;
+vector<string> words(string line){
+	vector<string> ws;
+	stringstream in(line);
+	string w;
+	while(in>>w){
+		ws.push_back(w);
+	}
+	return ws;
+}
+
+vector<string> splitLines(string text, char separator){
+	//the non-blank lines of text
+	vector<string> lines;
+	stringstream in(text);
+	string line;
+	while(getline(in, line, separator)){
+		if(!words(line).empty()){
+			lines.push_back(line);
+		}
+	}
+	return lines;
+}
+
+int compareOutput(string what, string actual, vector<string> expected){
+	//number of lines of actual output that differ from the expected ones, each printed
+	vector<string> got = splitLines(actual, '\n');
+	int mismatches = 0;
+	for(int i=0; i<got.size() || i<expected.size(); i++){
+		string g = (i<got.size() ? got[i] : "(nothing)");
+		string e = (i<expected.size() ? expected[i] : "(nothing)");
+		if(words(g)!=words(e)){
+			cout<<"MISMATCH: "<<what<<"\n\texpected: "<<e<<"\n\tactual:   "<<g<<endl;
+			mismatches++;
+		}
+	}
+	return mismatches;
+}
+
+class CaptureOutput{
+//collects what is written to cout while it exists
+public:
+	CaptureOutput(){
+		old = cout.rdbuf(out.rdbuf());
+	}
+	~CaptureOutput(){
+		cout.rdbuf(old);
+	}
+	string text(){
+		return out.str();
+	}
+private:
+	stringstream out;
+	streambuf* old;
+};
+
+string printed(Cursor result){
+	CaptureOutput capture;
+	result.print();
+	return capture.text();
+}
+
+int runScript(DBMS* dbms, string fileName, vector<string>& written){
+	//mismatches of the script's output, -1 if it can't be read. written: relations it wrote
+	ifstream inFile(fileName.c_str());
+	if(!inFile){
+		return -1;
+	}
+	vector<string> lines;
+	string line;
+	while(getline(inFile, line)){
+		if(!line.empty() && line[line.size()-1]=='\r'){
+			line.erase(line.size()-1);
+		}
+		lines.push_back(line);
+	}
+	int mismatches = 0;
+	for(int i=0; i<lines.size(); i++){
+		if(words(lines[i]).empty() || lines[i].compare(0, 2, "//")==0){
+			continue;
+		}
+		if(lines[i].compare(0, 4, "EXIT")==0){
+			break;
+		}
+		vector<string> expected;
+		for(int j=i+1; j<lines.size() && lines[j].compare(0, 3, "//>")==0; j++){
+			expected.push_back(lines[j].substr(3));
+		}
+		vector<string> cmd = words(lines[i]);
+		if(cmd[0]=="WRITE" && cmd.size()>1){
+			written.push_back(cmd[1].substr(0, cmd[1].find(';')));
+		}
+		string output;
+		{
+			CaptureOutput capture;
+			dbms->Execute(lines[i]);
+			output = capture.text();
+		}
+		mismatches += compareOutput(lines[i], output, expected);
+	}
+	return mismatches;
+}
+
+int runQueries(DBMS* dbms){
+	//the query builder, against baseball_players from testIn.txt
+	int mismatches = 0;
+	mismatches += compareOutput("from(baseball_players).where(homeruns >= 40).project(fname, team)",
+		printed(dbms->from("baseball_players").where(col("homeruns") >= 40).project("fname, team").run()),
+		splitLines("fname team|Joe Pirates|Sarah Dinosaurs|Donald Dinosaurs", '|'));
+	mismatches += compareOutput("from(baseball_players).where(team == Pirates && salary < 500000).rename(...)",
+		printed(dbms->from("baseball_players").where(col("team") == "Pirates" && col("salary") < 500000).project("lname, salary").rename("name, pay").run()),
+		splitLines("name pay|Slinger 200000|Smith 150000", '|'));
+#ifdef QUERY_INITIALIZER_LISTS
+	mismatches += compareOutput("from(baseball_players).project({lname}).rename({name})",
+		printed(dbms->from("baseball_players").where(col("homeruns") < 5).project({"lname"}).rename({"name"}).run()),
+		splitLines("name|Slinger|Smith", '|'));
+#endif
+	mismatches += compareOutput("from(shapes).where(shape == circle).product(from(colors))",
+		printed(dbms->from("shapes").where(col("shape") == "circle").product(dbms->from("colors")).run()),
+		splitLines("shape color|circle red|circle blue", '|'));
+	mismatches += compareOutput("from(baseball_players).where(team ^= Pi && homeruns > 2)",
+		printed(dbms->from("baseball_players").where((col("team") ^= "Pi") && col("homeruns") > 2).project("fname").run()),
+		splitLines("fname|Joe|Snoopy", '|'));
+	mismatches += compareOutput("from(teams).join(from(scores), tid, tid2).where(runs > 4)",
+		printed(dbms->from("teams").join(dbms->from("scores"), "tid", "tid2").where(col("runs") > 4).project("tname, runs").run()),
+		splitLines("tname runs|Pirates 7|Dinosaurs 5", '|')); //merged in tid order, through the indexes on tid and tid2
+	mismatches += compareOutput("from(scores).orderBy(runs, tid2)",
+		printed(dbms->from("scores").orderBy("runs, tid2").run()),
+		splitLines("tid2 runs|3 1|3 4|2 5|1 7", '|'));
+	mismatches += compareOutput("from(baseball_players).orderBy(salary).limit(2)",
+		printed(dbms->from("baseball_players").orderBy("salary").limit(2).project("fname, salary").run()),
+		splitLines("fname salary|Alexander 150000|Snoopy 200000", '|'));
+	mismatches += compareOutput("from(baseball_players).groupBy(team, countOf())",
+		printed(dbms->from("baseball_players").groupBy("team", countOf()).run()),
+		splitLines("team count|Pirates 3|Dinosaurs 2", '|'));
+#ifdef QUERY_INITIALIZER_LISTS
+	mismatches += compareOutput("from(baseball_players).groupBy({team}, {sumOf(homeruns), maxOf(salary)})",
+		printed(dbms->from("baseball_players").groupBy({"team"}, {sumOf("homeruns"), maxOf("salary")}).run()),
+		splitLines("team sum_homeruns max_salary|Pirates 45 1000000|Dinosaurs 189 5000000", '|'));
+#endif
+	//only count goes without an attribute
+	mismatches += compareOutput("from(baseball_players).groupBy(team, sumOf())",
+		printed(dbms->from("baseball_players").groupBy("team", sumOf("")).run()),
+		vector<string>());
+#ifdef QUERY_INITIALIZER_LISTS
+	mismatches += compareOutput("from(teams).orderBy({tname})",
+		printed(dbms->from("teams").orderBy({"tname"}).project({"tid"}).run()),
+		splitLines("tid|2|3|1", '|'));
+#endif
+	return mismatches;
+}
+
+void markOrThrow(vector<int>* marks, int i){
+	if(i == 3){
+		throw runtime_error("task 3 failed");
+	}
+	(*marks)[i] = 1;
+}
+
+string runGroup(TaskPool& pool, int tasks){
+	//what waiting for tasks markOrThrow tasks did: how many ran, and whether wait() threw
+	vector<int> marks(tasks, 0);
+	TaskGroup group;
+	for(int i=0; i<tasks; i++){
+		pool.submit(group, boost::bind(markOrThrow, &marks, i));
+	}
+	string caught = "no exception";
+	try{
+		pool.wait(group);
+	}catch(exception&){
+		caught = "exception";
+	}
+	int marked = 0;
+	for(int i=0; i<tasks; i++){
+		marked += marks[i];
+	}
+	stringstream out;
+	out<<marked<<" marked, "<<caught;
+	return out.str();
+}
+
+int runTaskPool(){
+	//a throwing task: the rest of its group still runs, wait() rethrows, and the workers live on
+	TaskPool pool(4);
+	int mismatches = 0;
+	mismatches += compareOutput("TaskPool: group with a throwing task", runGroup(pool, 64), splitLines("63 marked, exception", '|'));
+	mismatches += compareOutput("TaskPool: next group", runGroup(pool, 3), splitLines("3 marked, no exception", '|'));
+	return mismatches;
+}
+
+int main(){
+	DBMS* dbms1 = new DBMS(false, 1);
+	vector<string> written;
+	int mismatches = runScript(dbms1, "testIn.txt", written);
+	if(mismatches<0){
+		cout<<"Could not read testIn.txt\n";
+		return 1;
+	}
+	mismatches += runQueries(dbms1);
+	mismatches += runTaskPool();
+	for(int i=0; i<written.size(); i++){
+		//leave nothing behind in the working directory
+		remove((written[i]+".db").c_str());
+		remove((written[i]+".idx").c_str());
+	}
+	cout<<mismatches<<" mismatches\n";
+	return (mismatches==0 ? 0 : 1);
 }
 
 
@@ -190,10 +190,9 @@ string addNewCustomerMenu(){
 	}while(choice!='1'&&choice!='5');
 	if(choice=='1'){
 		white("INSERT INTO customers VALUES FROM (\""+userId+"\",\""+firstName+"\",\""+lastName+"\",\""+phoneNumber+"\");");cout<<endl;//printSTok();
-		exeDBMS1.Execute("OPEN customers;");
 		exeDBMS1.Execute("INSERT INTO customers VALUES FROM (\""+userId+"\",\""+firstName+"\",\""+lastName+"\",\""+phoneNumber+"\");");
 		exeDBMS1.Execute("SHOW customers;");
-		exeDBMS1.Execute("CLOSE customers;");
+		exeDBMS1.Execute("WRITE customers;");
 
 		system("pause");
 	}
@@ -212,10 +211,8 @@ string removeCustomerMenu(){
 	white("customerToDelete <- select (userId == "+idToDelete+") customers;");cout<<endl;//printSTok();
 	white("SHOW customerToDelete;");cout<<endl;
 	//red("");centerstring("NOT YET IMPLEMENTED");
-	exeDBMS1.Execute("OPEN customers;");
 	exeDBMS1.Execute("customerToDelete <- select (userId == "+idToDelete+") customers;");
 	exeDBMS1.Execute("SHOW customerToDelete;");
-	exeDBMS1.Execute("CLOSE customers;");
 	white("");cout<<idToDelete<<", "+firstName+", "+lastName+", "+phoneNumber<<endl;
 	green("*");white("1");green(" to Remove the above customer, ");white("5");green(" to change, any key to go back:");
 	do{
@@ -224,10 +221,9 @@ string removeCustomerMenu(){
 	if(choice=='1'){
 		white("DELETE FROM customers WHERE (userId == "+idToDelete+");");white("");cout<<endl;
 		red("");centerstring("NOT YET IMPLEMENTED");
-		exeDBMS1.Execute("OPEN customers;");
 		exeDBMS1.Execute("DELETE FROM customers WHERE (userId == "+idToDelete+");");
 		exeDBMS1.Execute("SHOW customers;");
-		exeDBMS1.Execute("CLOSE customers;");
+		exeDBMS1.Execute("WRITE customers;");
 		white("");system("pause");
 	}
 	else if(choice=='5')
@@ -243,10 +239,8 @@ string updateCustomerMenu(){
 	title("Update Customer");green("*Enter Customer's User ID:");white("");cin>>idToUpdate;
 	white("customerToUpdate <- select (userId == \""+idToUpdate+"\") customers;");cout<<endl;//printSTok();
 	white("SHOW customerToUpdate;");cout<<endl;//printSTok();
-	exeDBMS1.Execute("OPEN customers;");
 	exeDBMS1.Execute("customerToUpdate <- select (userId == \""+idToUpdate+"\") customers;");
 	exeDBMS1.Execute("SHOW customerToUpdate;");
-	exeDBMS1.Execute("CLOSE customers;");
 	//red("");centerstring("NOT YET IMPLEMENTED");
 	//white("");cout<<idToUpdate<<", "+firstName+", "+lastName+", "+phoneNumber<<endl;
 	green("*");white("1");green(" to update the customer, ");white("5");green(" to change, any key to go back:");
@@ -267,11 +261,10 @@ string updateCustomerMenu(){
 		green("*Enter Customer's First Name:");white("");cin>>firstName;
 		white("UPDATE customers SET firstName = \""+firstName+"\" WHERE userId == \""+idToUpdate+"\";");cout<<endl;
 		white("updatedCustomer <- select (userId == \""+idToUpdate+"\") customers;");cout<<endl;
-		exeDBMS1.Execute("OPEN customers;");
 		exeDBMS1.Execute("UPDATE customers SET firstName = \""+firstName+"\" WHERE userId == \""+idToUpdate+"\";");
 		exeDBMS1.Execute("updatedCustomer <- select (userId == \""+idToUpdate+"\") customers;");
 		exeDBMS1.Execute("SHOW updatedCustomer;");
-		exeDBMS1.Execute("CLOSE customers;");
+		exeDBMS1.Execute("WRITE customers;");
 		//red("");centerstring("NOT YET IMPLEMENTED");
 		//white("");cout<<idToUpdate<<", "+firstName+", "+lastName+", "+phoneNumber<<endl;
 	}
@@ -279,10 +272,9 @@ string updateCustomerMenu(){
 		green("*Enter Customer's Last Name:");white("");cin>>lastName;
 		white("UPDATE customers SET lastName == \""+lastName+"\" WHERE userId == \""+idToUpdate+"\";");cout<<endl;
 		white("updatedCustomer <- select (userId == \""+idToUpdate+"\") customers;");cout<<endl;
-		exeDBMS1.Execute("OPEN customers;");
 		exeDBMS1.Execute("UPDATE customers SET lastName = \""+lastName+"\" WHERE userId == \""+idToUpdate+"\";");
 		exeDBMS1.Execute("updatedCustomer <- select (userId == \""+idToUpdate+"\") customers;");
-		exeDBMS1.Execute("CLOSE customers;");
+		exeDBMS1.Execute("WRITE customers;");
 		red("");centerstring("NOT YET IMPLEMENTED");white("");
 		//cout<<idToUpdate<<", "+firstName+", "+lastName+", "+phoneNumber<<endl;
 	}
@@ -290,10 +282,9 @@ string updateCustomerMenu(){
 		green("*Enter Customer's Phone Number:");white("");cin>>phoneNumber;
 		white("UPDATE customers SET phoneNumber == \""+phoneNumber+"\" WHERE userId == \""+idToUpdate+"\";");cout<<endl;
 		white("updatedCustomer <- select (userId == \""+idToUpdate+"\") customers;");cout<<endl;
-		exeDBMS1.Execute("OPEN customers;");
 		exeDBMS1.Execute("UPDATE customers SET phoneNumber = "+phoneNumber+" WHERE userId == "+idToUpdate+";");
 		exeDBMS1.Execute("updatedCustomer <- select (userId == "+idToUpdate+") customers;");
-		exeDBMS1.Execute("CLOSE customers;");
+		exeDBMS1.Execute("WRITE customers;");
 		red("");centerstring("NOT YET IMPLEMENTED");white("");
 		cout<<idToUpdate<<", "+firstName+", "+lastName+", "+phoneNumber<<endl;
 	}
@@ -315,9 +306,7 @@ string listCustomerMenu(){
 	}while(choice!='1'&&choice!='5');
 	if(choice=='1'){
 		white("");
-		exeDBMS1.Execute("OPEN customers;");
 		exeDBMS1.Execute("SHOW customers;");
-		exeDBMS1.Execute("CLOSE customers;");
 		system("pause");
 	}else if(choice=='5');
 		return "customerMenu";
@@ -327,8 +316,8 @@ string searchCustomerMenu(){
 	int selection=NULL;
 	string userId="userId",firstName="fName",lastName="lName",phoneNumber="phone#";	char choice;
 	title("Search Customers");
-	green("*");white("(1)");green("Search by First Name");cout<<endl;
-	green("*");white("(2)");green("Search by Last Name");cout<<endl;
+	green("*");white("(1)");green("Search by First Name (or its beginning)");cout<<endl;
+	green("*");white("(2)");green("Search by Last Name (or its beginning)");cout<<endl;
 	green("*");white("(3)");green("Search by Phone NUmber");cout<<endl;
 	green("*");cout<<endl;
 	green("*");white("(5)");green("Go back to main menu");cout<<endl;
@@ -337,37 +326,22 @@ string searchCustomerMenu(){
 	}while(choice!='1'&&choice!='2'&&choice!='3'&&choice!='5');
 	if(choice=='1'){
 		green("*Enter First Name to search for:");white("");cin>>firstName;
-		white("searchByFirstName <- select (firstName == \""+firstName+"\") customers;");cout<<endl;
-		white("SHOW searchByFirstName;");cout<<endl;
-		exeDBMS1.Execute("OPEN customers;");
-		exeDBMS1.Execute("searchByFirstName <- select (firstName == \""+firstName+"\") customers;");
-		exeDBMS1.Execute("SHOW searchByFirstName;");
+		exeDBMS1.from("customers").where(col("firstName") ^= firstName).run().print();
 		//red("");centerstring("NOT YET IMPLEMENTED");white("");
-		exeDBMS1.Execute("CLOSE customers;");
 		
 		//for(int i=0;i<10;i++)
 			//cout<<userId<<", "+firstName+", "+lastName+", "+phoneNumber<<endl;
 	}
 	else if(choice=='2'){
 		green("*Enter Last Name to search for:");white("");cin>>lastName;
-		white("searchByLastName <- select (lastName = "+lastName+") customers;");cout<<endl;
-		white("SHOW searchByLastName;");cout<<endl;
-		exeDBMS1.Execute("OPEN customers;");
-		exeDBMS1.Execute("searchByFirstName <- select (lastName == \""+lastName+"\") customers;");
-		exeDBMS1.Execute("SHOW searchByLastName;");
-		exeDBMS1.Execute("CLOSE customers;");
+		exeDBMS1.from("customers").where(col("lastName") ^= lastName).run().print();
 		//red("");centerstring("NOT YET IMPLEMENTED");white("");
 		//for(int i=0;i<10;i++)
 			//cout<<userId<<", "+firstName+", "+lastName+", "+phoneNumber<<endl;
 	}
 	else if(choice=='3'){
 		green("*Enter Phone Number to search for:");white("");cin>>phoneNumber;
-		white("searchByPhoneNumber <- select (phoneNumber == "+phoneNumber+") customers;");cout<<endl;
-		white("SHOW searchByPhoneNumber;");cout<<endl;
-		exeDBMS1.Execute("OPEN customers;");
-		exeDBMS1.Execute("searchByPhoneNumber <- select (phoneNumber == \""+phoneNumber+"\") customers;");
-		exeDBMS1.Execute("SHOW searchByPhoneNumber;");
-		exeDBMS1.Execute("CLOSE customers;");
+		exeDBMS1.from("customers").where(col("phoneNumber") == phoneNumber).run().print();
 		//red("");centerstring("NOT YET IMPLEMENTED");white("");
 		//for(int i=0;i<10;i++)
 			//cout<<userId<<", "+firstName+", "+lastName+", "+phoneNumber<<endl;
@@ -394,10 +368,9 @@ string addNewDvdMenu(){
 	}while(choice!='1'&&choice!='5');
 	if(choice=='1'){
 		white("INSERT INTO dvds VALUES FROM (\""+inventoryNumber+"\",\""+dvdId+"\",\""+dvdTitle+"\");");cout<<endl;
-		exeDBMS1.Execute("OPEN dvds;");
 		exeDBMS1.Execute("INSERT INTO dvds VALUES FROM (\""+inventoryNumber+"\",\""+dvdId+"\",\""+dvdTitle+"\");");
 		exeDBMS1.Execute("SHOW dvds;");
-		exeDBMS1.Execute("CLOSE dvds;");
+		exeDBMS1.Execute("WRITE dvds;");
 		system("pause");
 	}else if(choice=='5')
 		return "addNewDvdMenu";
@@ -412,10 +385,8 @@ string removeDvdMenu(){
 	green("*Enter Inventory Number to remove:");white("");cin>>idToDelete;
 	white("dvdToDelete <- select (inventoryNumber == "+idToDelete+") dvds;");cout<<endl;
 	white("SHOW dvdToDelete;");cout<<endl;
-	exeDBMS1.Execute("OPEN dvds;");
 	exeDBMS1.Execute("dvdToDelete <- select (dvdId == "+idToDelete+") dvds;");
 	exeDBMS1.Execute("SHOW dvdToDelete;");
-	exeDBMS1.Execute("CLOSE dvds;");
 	//red("");centerstring("NOT YET IMPLEMENTED");white("");
 	cout<<idToDelete<<", "+dvdId+", "+dvdTitle<<endl;
 	green("*");white("1");green(" to Remove the above DVD, ");white("5");green(" to change, any key to go back:");
@@ -424,9 +395,8 @@ string removeDvdMenu(){
 	}while(choice!='1'&&choice!='5');
 	if(choice=='1'){
 		white("DELETE FROM dvds WHERE (inventoryNumber == "+idToDelete+");");cout<<endl;
-		exeDBMS1.Execute("OPEN dvds;");
 		exeDBMS1.Execute("DELETE FROM dvds WHERE (inventoryNumber = "+idToDelete+");");
-		exeDBMS1.Execute("CLOSE dvds;");
+		exeDBMS1.Execute("WRITE dvds;");
 		red("");centerstring("NOT YET IMPLEMENTED");white("");
 		system("pause");
 	}
@@ -444,10 +414,8 @@ string updateDvdMenu(){
 	green("*Enter Inventory Number:");white("");cin>>idToUpdate;
 	white("dvdToUpdate <- select (inventoryNUmber == "+idToUpdate+") dvds;");cout<<endl;
 	white("SHOW dvdToUpdate;");cout<<endl;
-	exeDBMS1.Execute("OPEN dvds;");
 	exeDBMS1.Execute("dvdToUpdate <- select (inventoryNumber == "+idToUpdate+") dvds;");
 	exeDBMS1.Execute("SHOW dvdToUpdate;");
-	exeDBMS1.Execute("CLOSE dvds;");
 	//red("");centerstring("NOT YET IMPLEMENTED");white("");
 	cout<<idToUpdate<<", "+dvdId+", "+dvdTitle<<endl;
 	green("*");white("1");green(" to Update the DVD, ");white("5");green(" to change, any key to go back:");
@@ -468,10 +436,9 @@ string updateDvdMenu(){
 		green("*Enter DVD's ID:");white("");cin>>dvdId;
 		white("UPDATE dvds SET dvdId == "+dvdId+" WHERE inventoryNumber == "+idToUpdate+";");cout<<endl;
 		white("updatedDvd <- select (inventoryNumber == "+idToUpdate+") dvds;");cout<<endl;
-		exeDBMS1.Execute("OPEN dvds;");
 		exeDBMS1.Execute("UPDATE dvds SET dvdId == "+dvdId+" WHERE inventoryNumber == "+idToUpdate+";");
 		exeDBMS1.Execute("updatedDvd <- select (inventoryNumber == "+idToUpdate+") dvds;");
-		exeDBMS1.Execute("CLOSE dvds;");
+		exeDBMS1.Execute("WRITE dvds;");
 		//red("");centerstring("NOT YET IMPLEMENTED");white("");
 		cout<<inventoryNumber<<", "+dvdId+", "+dvdTitle<<endl;
 	}
@@ -504,9 +471,7 @@ string listDvdMenu(){
 	}while(choice!='1'&&choice!='2'&&choice!='5');
 	if(choice=='1'){
 		white("SHOW dvds;");cout<<endl;
-		exeDBMS1.Execute("OPEN dvds;");
 		exeDBMS1.Execute("SHOW dvds;");
-		exeDBMS1.Execute("CLOSE dvds;");
 		for(int i=0;i<10;i++)
 			cout<<dvdId<<", "+inventoryNumber+", "+dvdTitle<<endl;
 		system("pause");
@@ -520,7 +485,7 @@ string searchDvdMenu(){
 	char choice;
 	title("Search DVDs");
 	green("*");white("(1)");green("Search by DVD ID");cout<<endl;
-	green("*");white("(2)");green("Search by Title");cout<<endl;
+	green("*");white("(2)");green("Search by Title (or its beginning)");cout<<endl;
 	green("*");cout<<endl;
 	green("*");white("(5)");green("Go back to main menu");cout<<endl;
 	do{
@@ -528,23 +493,14 @@ string searchDvdMenu(){
 	}while(choice!='1'&&choice!='2'&&choice!='5');
 	if(choice=='1'){
 		green("*Enter ID to search for:");white("");cin>>dvdId;
-		white("searchById <- select (dvdId == "+dvdId+") dvds;");cout<<endl;
-		exeDBMS1.Execute("OPEN dvds;");
-		exeDBMS1.Execute("searchById <- select (dvdId == "+dvdId+") dvds;");
-		exeDBMS1.Execute("SHOW searchById;");
-		exeDBMS1.Execute("CLOSE dvds;");
+		exeDBMS1.from("dvds").where(col("dvdId") == dvdId).run().print();
 		//red("");centerstring("NOT YET IMPLEMENTED");white("");
 		//for(int i=0;i<10;i++)
 			//cout<<inventoryNumber<<", "+dvdId+", "+dvdTitle<<endl;
 	}
 	else if(choice=='2'){
 		green("*Enter Title to search for:");white("");cin.clear();cin.sync();getline(cin,dvdTitle);
-		white("searchByTitle <- select (dvdTitle == "+dvdTitle+") dvds;");cout<<endl;
-		white("SHOW searchByTitle");cout<<endl;
-		exeDBMS1.Execute("OPEN dvds;");
-		exeDBMS1.Execute("searchByTitle <- select (dvdTitle == "+dvdTitle+") dvds");
-		exeDBMS1.Execute("SHOW searchByTitle;");
-		exeDBMS1.Execute("CLOSE dvds;");
+		exeDBMS1.from("dvds").where(col("title") ^= dvdTitle).run().print();
 		//red("");centerstring("NOT YET IMPLEMENTED");white("");
 		//for(int i=0;i<10;i++)
 			//cout<<inventoryNumber<<", "+dvdId+", "+dvdTitle<<endl;
@@ -593,7 +549,7 @@ string searchAvailableDvdMenu(){
 	char choice;
 	title("Search available DVDs");
 	green("*");white("(1)");green("Search by DVD ID");cout<<endl;
-	green("*");white("(2)");green("Search by Title");cout<<endl;
+	green("*");white("(2)");green("Search by Title (or its beginning)");cout<<endl;
 	green("*");cout<<endl;
 	green("*");white("(5)");green("Go back to main menu");cout<<endl;
 	do{
@@ -602,10 +558,8 @@ string searchAvailableDvdMenu(){
 	if(choice=='1'){
 		green("*Enter ID to search for:");white("");cin>>dvdId;
 		white("searchById <- select (dvdId == "+dvdId+") dvds;");cout<<endl;
-		exeDBMS1.Execute("OPEN dvds;");
 		exeDBMS1.Execute("searchById <- select (dvdId == "+dvdId+") dvds;");
 		//exeDBMS1.Execute("SHOW searchById;");
-		exeDBMS1.Execute("CLOSE dvds;");
 		red("");centerstring("NOT YET IMPLEMENTED");white("");
 		for(int i=0;i<10;i++)
 			cout<<dvdId<<", "+inventoryNumber+", "+dvdTitle<<endl;
@@ -613,10 +567,8 @@ string searchAvailableDvdMenu(){
 	else if(choice=='2'){
 		green("*Enter Title to search for:");white("");cin.clear();cin.sync();getline(cin,dvdTitle);
 		white("searchByTitle <- select (dvdTitle == "+dvdTitle+") dvds;");cout<<endl;
-		exeDBMS1.Execute("OPEN dvds;");
 		exeDBMS1.Execute("searchByTitle <- select (dvdTitle == "+dvdTitle+") dvds");
 		//exeDBMS1.Execute("SHOW searchByTitle;");
-		exeDBMS1.Execute("CLOSE dvds;");
 		red("");centerstring("NOT YET IMPLEMENTED");white("");
 		for(int i=0;i<10;i++)
 			cout<<dvdId<<", "+inventoryNumber+", "+dvdTitle<<endl;
@@ -645,10 +597,9 @@ string checkOutDvdMenu(){
 	if(choice=='1'){
 		white("");
 		white("INSERT INTO rentals VALUES FROM (\""+userId+"\",\""+inventoryNumber+"\",\""+checkOutDate+"\", \"out\");");cout<<endl;
-		exeDBMS1.Execute("OPEN rentals;");
 		exeDBMS1.Execute("INSERT INTO rentals VALUES FROM (\""+userId+"\",\""+inventoryNumber+"\",\""+checkOutDate+"\", \"out\");");
 		exeDBMS1.Execute("SHOW rentals;");
-		exeDBMS1.Execute("CLOSE rentals;");
+		exeDBMS1.Execute("WRITE rentals;");
 		system("pause");
 	}
 	else if(choice=='5')
@@ -674,9 +625,8 @@ string checkInDvdMenu()
 	if(choice=='1'){
 		white("");
 		cout<<"UPDATE rentals SET checkInDate == \""<<checkInDate<<"\" WHERE dvdId == "+dvdId+";"<<endl;
-		exeDBMS1.Execute("OPEN rentals;");
 		exeDBMS1.Execute("UPDATE rentals SET checkInDate = \""+checkInDateStr+"\" WHERE dvdId == \""+dvdId+"\";");
-		exeDBMS1.Execute("CLOSE rentals;");
+		exeDBMS1.Execute("WRITE rentals;");
 		//red("");centerstring("NOT YET IMPLEMENTED");white("");
 		system("pause");
 	}
@@ -700,12 +650,7 @@ string listRentalsByCustomerMenu(){
 	}while(choice!='1'&&choice!='5');
 	if(choice=='1'){
 		green("*Enter Customer ID to search for:");white("");cin>>userId;
-		white("rentalsByCustomer <- select (userId == "+userId+") rentals;");cout<<endl;
-		white("SHOW rentalsByCustomer;");cout<<endl;
-		exeDBMS1.Execute("OPEN rentals;");
-		exeDBMS1.Execute("rentalsByCustomer <- select (userId == "+userId+") rentals;");
-		exeDBMS1.Execute("SHOW rentalsByCustomer;");
-		exeDBMS1.Execute("CLOSE rentals;");
+		exeDBMS1.from("rentals").where(col("userId") == userId).orderBy("checkOutDate").run().print();
 		red("");centerstring("NOT YET IMPLEMENTED");white("");
 		white("");
 		for(int i=0;i<10;i++)
@@ -721,6 +666,8 @@ void createDatabases(){
 	ifstream customers("./customers.db");
 	ifstream dvds("./dvds.db");
 	ifstream rentals("./rentals.db");
+	ifstream customerIndexes("./customers.idx");
+	ifstream dvdIndexes("./dvds.idx");
 	if (!customers.good()){
 		white("CREATE TABLE customers;");cout<<endl;
 		exeDBMS1.Execute("CREATE TABLE customers (userId VARCHAR(20), firstName VARCHAR(20), lastName VARCHAR(20), phoneNumber VARCHAR(20)) PRIMARY KEY (userId);");
@@ -736,6 +683,16 @@ void createDatabases(){
 		exeDBMS1.Execute("CREATE TABLE rentals (rentalId VARCHAR(20), userId VARCHAR(20), inventoryNumber VARCHAR(20), checkOutDate VARCHAR(20), checkInDate VARCHAR(20)) PRIMARY KEY (rentalId);");
 		exeDBMS1.Execute("WRITE rentals;");
 	}
+	if (!customerIndexes.good()){
+		//name searches are prefix searches, answered from these indexes
+		exeDBMS1.Execute("CREATE INDEX customerFirstNames ON customers (firstName);");
+		exeDBMS1.Execute("CREATE INDEX customerLastNames ON customers (lastName);");
+		exeDBMS1.Execute("WRITE customers;");
+	}
+	if (!dvdIndexes.good()){
+		exeDBMS1.Execute("CREATE INDEX dvdTitles ON dvds (title);");
+		exeDBMS1.Execute("WRITE dvds;");
+	}
 	system("pause");
 }
 //User choice handler: all of the above Command Menus are called from here